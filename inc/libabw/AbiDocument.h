@@ -12,6 +12,8 @@
 
 #include <librevenge/librevenge.h>
 
+#include "AbiParseOptions.h"
+
 #ifdef DLL_EXPORT
 #ifdef LIBABW_BUILD
 #define ABWAPI __declspec(dllexport)
@@ -29,6 +31,9 @@
 namespace libabw
 {
 
+struct AbiParseStatistics;
+class AbiPreparedDocument;
+
 /**
 This class provides all the functions an application would need to parse
 AbiWord documents.
@@ -39,6 +44,12 @@ class AbiDocument
 public:
   static ABWAPI bool isFileFormatSupported(librevenge::RVNGInputStream *input);
   static ABWAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *documentInterface);
+  static ABWAPI bool parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *documentInterface,
+                           AbiParseStatistics *statistics);
+  static ABWAPI ABWResult parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *documentInterface,
+                                const AbiParseOptions &options);
+  static ABWAPI AbiPreparedDocument *open(librevenge::RVNGInputStream *input);
+  static ABWAPI AbiPreparedDocument *open(librevenge::RVNGInputStream *input, const AbiParseOptions &options);
 };
 
 } // namespace libabw
@@ -0,0 +1,64 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef ABIMAPPEDFILESTREAM_H
+#define ABIMAPPEDFILESTREAM_H
+
+#include <memory>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "AbiDocument.h"
+
+namespace libabw
+{
+
+/**
+An input stream over a local file that is mapped into memory.
+
+It can be used instead of librevenge::RVNGFileStream. As the whole file
+is available in memory, the parser passes it to libxml2 directly,
+without copying. If the file cannot be opened or mapped, the stream is
+empty.
+*/
+class ABWAPI AbiMappedFileStream : public librevenge::RVNGInputStream
+{
+public:
+  explicit AbiMappedFileStream(const char *filename);
+  ~AbiMappedFileStream() override;
+
+  bool isStructured() override;
+  unsigned subStreamCount() override;
+  const char *subStreamName(unsigned id) override;
+  bool existsSubStream(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamById(unsigned id) override;
+
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+  //! the content of the whole file, or nullptr if it is empty
+  const unsigned char *getData() const;
+  //! the size of the file
+  unsigned long getSize() const;
+
+private:
+  AbiMappedFileStream(const AbiMappedFileStream &);
+  AbiMappedFileStream &operator=(const AbiMappedFileStream &);
+
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace libabw
+
+#endif /* ABIMAPPEDFILESTREAM_H */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
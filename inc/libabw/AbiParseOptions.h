@@ -0,0 +1,154 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef ABIPARSEOPTIONS_H
+#define ABIPARSEOPTIONS_H
+
+#include <atomic>
+#include <chrono>
+
+namespace libabw
+{
+
+struct AbiParseStatistics;
+
+/**
+Result of AbiDocument::parse() called with AbiParseOptions.
+*/
+enum ABWResult
+{
+  ABW_OK, //!< the document was converted
+  ABW_PARSE_ERROR, //!< the document could not be parsed
+  ABW_CANCELLED, //!< the parsing was cancelled or its deadline has passed
+  ABW_LIMIT_EXCEEDED //!< the document exceeds one of the AbiParseLimits
+};
+
+/**
+The interface of libxml2 the XML is read with.
+
+Both produce the same output.
+*/
+enum ABWXMLFrontend
+{
+  ABW_XML_READER, //!< xmlTextReader, which pulls the nodes one by one
+  ABW_XML_SAX //!< SAX2 callbacks, which avoid building and querying a node for each
+};
+
+/**
+Limits on the resources a document may use during the parsing.
+
+A value of 0 means unlimited; all limits are unlimited by default. The
+parsing is aborted with ABW_LIMIT_EXCEEDED as soon as a limit is
+exceeded, so they can be used to protect against hostile input, e.g.,
+compression bombs.
+*/
+struct AbiParseLimits
+{
+  AbiParseLimits()
+    : m_maxInflatedBytes(0)
+    , m_maxDepth(0)
+    , m_maxNodes(0)
+    , m_maxDataBytes(0)
+    , m_maxOutputElements(0)
+  {
+  }
+
+  //! maximal size of a decompressed document
+  unsigned long m_maxInflatedBytes;
+  //! maximal nesting depth of XML elements
+  unsigned long m_maxDepth;
+  //! maximal number of XML nodes
+  unsigned long m_maxNodes;
+  //! maximal total size of embedded data (images etc.), after base64 decoding
+  unsigned long m_maxDataBytes;
+  //! maximal number of output elements buffered before they are written
+  unsigned long m_maxOutputElements;
+};
+
+/**
+Optional settings for AbiDocument::parse().
+
+The default-constructed options do not change the behavior of the
+parser in any way.
+*/
+struct AbiParseOptions
+{
+  AbiParseOptions()
+    : m_statistics(nullptr)
+    , m_cancel(nullptr)
+    , m_deadline(std::chrono::steady_clock::time_point::max())
+    , m_limits()
+    , m_pipelined(false)
+    , m_xmlFrontend(ABW_XML_READER)
+    , m_contentThreads(0)
+    , m_dataThreads(0)
+    , m_reserved()
+  {
+  }
+
+  //! statistics to fill, or nullptr
+  AbiParseStatistics *m_statistics;
+
+  /** a flag that can be set (from any thread) to abort the parsing, or nullptr
+
+      It is checked while decompressing the input, for every XML node
+      and for every element of the output.
+    */
+  const std::atomic<bool> *m_cancel;
+
+  //! the point in time after which the parsing is aborted
+  std::chrono::steady_clock::time_point m_deadline;
+
+  //! resource limits
+  AbiParseLimits m_limits;
+
+  /** inflate large gzip-compressed documents on a separate thread
+
+      The decompression then overlaps with the parsing, which uses the
+      calling thread as before. It has no effect on other documents.
+
+      gzip-compressed documents that inflate to more than 16 MiB are
+      not kept in memory, but inflated on demand, with or without this
+      option. That uses zlib, or zlib-ng if libabw was built with it;
+      libdeflate, which can only inflate a whole document at once, is
+      only used for smaller documents.
+    */
+  bool m_pipelined;
+
+  //! the interface of libxml2 to read the XML with
+  ABWXMLFrontend m_xmlFrontend;
+
+  /** the number of threads to parse the content of large documents with
+
+      The content is split between top-level sections, and the parts are
+      parsed concurrently; the output is the same as that of the parsing
+      on the calling thread. It is only done for documents that are in
+      memory, i.e., mapped files and compressed documents that are not
+      inflated on demand. 0 and 1 mean that the calling thread is used
+      only.
+    */
+  unsigned m_contentThreads;
+
+  /** the number of threads to decode the base64 data, e.g., the
+      images, embedded in the document with
+
+      Large data are decoded while the parsing goes on. 0 means that
+      they are decoded on the calling thread, when they are read.
+    */
+  unsigned m_dataThreads;
+
+private:
+  //! room for the options of later versions, so that the size of the structure stays the same
+  void *m_reserved[8];
+};
+
+} // namespace libabw
+
+#endif /* ABIPARSEOPTIONS_H */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,84 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef ABIPARSESTATISTICS_H
+#define ABIPARSESTATISTICS_H
+
+#include <librevenge/librevenge.h>
+
+namespace libabw
+{
+
+/**
+Timings and counters collected during a call of AbiDocument::parse().
+
+Pass an instance to the corresponding AbiDocument::parse() overload to
+have it filled. Values are accumulated, so the same object can be reused
+to collect totals over several documents. Nothing is measured when no
+statistics object is passed.
+*/
+struct AbiParseStatistics
+{
+  enum Phase
+  {
+    PHASE_DECOMPRESSION, //!< inflating a compressed document; large ones are inflated during the passes
+    PHASE_STYLES, //!< the first pass: styles, lists, tables sizes and data
+    PHASE_CONTENT, //!< the second pass, excluding the output replay
+    PHASE_OUTPUT, //!< replaying the buffered output to the text interface
+    PHASE_COUNT
+  };
+
+  AbiParseStatistics()
+    : m_wallTime()
+    , m_cpuTime()
+    , m_elementCounts()
+    , m_inflatedBytes(0)
+    , m_nodeCount(0)
+    , m_unknownElementCount(0)
+    , m_attributeBytes(0)
+    , m_base64DecodedBytes(0)
+    , m_outputElementCount(0)
+    , m_peakBufferedElements(0)
+    , m_contentPartCount(0)
+    , m_reparsedContentPartCount(0)
+  {
+  }
+
+  //! wall clock time spent in each phase, in seconds
+  double m_wallTime[PHASE_COUNT];
+  //! processor time spent in each phase, in seconds
+  double m_cpuTime[PHASE_COUNT];
+
+  //! number of known AWML elements, as int properties named by the elements
+  librevenge::RVNGPropertyList m_elementCounts;
+
+  //! size of the decompressed document (0 if it was not compressed)
+  unsigned long m_inflatedBytes;
+  //! number of XML nodes read in the styles pass
+  unsigned long m_nodeCount;
+  //! number of elements not known to libabw
+  unsigned long m_unknownElementCount;
+  //! total length of the attribute values of all elements
+  unsigned long m_attributeBytes;
+  //! number of bytes produced by decoding base64 data
+  unsigned long m_base64DecodedBytes;
+  //! number of output elements replayed to the text interface
+  unsigned long m_outputElementCount;
+  //! maximal number of output elements buffered at once
+  unsigned long m_peakBufferedElements;
+  //! number of parts the content was split into to be parsed concurrently (0 if it was not split)
+  unsigned long m_contentPartCount;
+  //! number of those parts that had to be parsed again, on the calling thread
+  unsigned long m_reparsedContentPartCount;
+};
+
+} // namespace libabw
+
+#endif /* ABIPARSESTATISTICS_H */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
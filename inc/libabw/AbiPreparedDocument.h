@@ -0,0 +1,73 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef ABIPREPAREDDOCUMENT_H
+#define ABIPREPAREDDOCUMENT_H
+
+#include <memory>
+
+#include <librevenge/librevenge.h>
+
+#include "AbiDocument.h"
+#include "AbiParseOptions.h"
+
+namespace libabw
+{
+
+/**
+A document opened by AbiDocument::open().
+
+The document is decompressed only once, when it is opened; the format
+detection, the metadata and any number of parse() calls then share the
+result. The input stream must exist as long as this object.
+*/
+class ABWAPI AbiPreparedDocument
+{
+public:
+  ~AbiPreparedDocument();
+
+  //! whether the document looks like an AbiWord document, like AbiDocument::isFileFormatSupported()
+  bool isSupported();
+
+  /** the metadata of the document, as it would be passed to
+      librevenge::RVNGTextInterface::setDocumentMetaData()
+
+      It is read without parsing the whole document. The list is empty if
+      the document is not supported.
+    */
+  const librevenge::RVNGPropertyList &getMetadata();
+
+  //! parse the document, like AbiDocument::parse()
+  bool parse(librevenge::RVNGTextInterface *documentInterface);
+
+  /** parse the document with options, like AbiDocument::parse()
+
+      The decompression is done by AbiDocument::open(), so it is subject to
+      the options passed there, and its time is not included in the
+      statistics of this call. If it was aborted, the result is returned.
+      The inflated size is only counted into the statistics of the first
+      call that has any.
+    */
+  ABWResult parse(librevenge::RVNGTextInterface *documentInterface, const AbiParseOptions &options);
+
+private:
+  friend class AbiDocument;
+
+  AbiPreparedDocument(librevenge::RVNGInputStream *input, const AbiParseOptions &options);
+  AbiPreparedDocument(const AbiPreparedDocument &);
+  AbiPreparedDocument &operator=(const AbiPreparedDocument &);
+
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace libabw
+
+#endif /* ABIPREPAREDDOCUMENT_H */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
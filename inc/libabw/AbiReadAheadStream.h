@@ -0,0 +1,64 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef ABIREADAHEADSTREAM_H
+#define ABIREADAHEADSTREAM_H
+
+#include <memory>
+
+#include <librevenge-stream/librevenge-stream.h>
+
+#include "AbiDocument.h"
+
+namespace libabw
+{
+
+/**
+An input stream that reads another stream in large blocks, ahead of use.
+
+It is meant for streams with slow or high-latency reads, e.g., files on
+a network filesystem. While the parser consumes a block, the next one is
+read on a background thread, so the waiting for I/O overlaps with the
+parsing.
+
+The input stream is not owned. It must support seeking to its end, as
+its size is needed; otherwise all calls are simply forwarded to it. The
+input must not be used while this stream exists; when it is destroyed,
+the input is positioned at the current offset of this stream.
+*/
+class ABWAPI AbiReadAheadStream : public librevenge::RVNGInputStream
+{
+public:
+  explicit AbiReadAheadStream(librevenge::RVNGInputStream *input, unsigned long blockSize = 1024 * 1024);
+  ~AbiReadAheadStream() override;
+
+  bool isStructured() override;
+  unsigned subStreamCount() override;
+  const char *subStreamName(unsigned id) override;
+  bool existsSubStream(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamByName(const char *name) override;
+  librevenge::RVNGInputStream *getSubStreamById(unsigned id) override;
+
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+private:
+  AbiReadAheadStream(const AbiReadAheadStream &);
+  AbiReadAheadStream &operator=(const AbiReadAheadStream &);
+
+  struct Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace libabw
+
+#endif /* ABIREADAHEADSTREAM_H */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -12,6 +12,11 @@
 #define LIBABW_H
 
 #include "AbiDocument.h"
+#include "AbiMappedFileStream.h"
+#include "AbiParseOptions.h"
+#include "AbiParseStatistics.h"
+#include "AbiPreparedDocument.h"
+#include "AbiReadAheadStream.h"
 
 #endif /* LIBABW_H */
 /* vim:set shiftwidth=4 softtabstop=4 noexpandtab: */
@@ -0,0 +1,138 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <libabw/libabw.h>
+
+#include "ABWDecompressor.h"
+
+namespace
+{
+
+int printUsage()
+{
+  printf("`abwinflatebench' compares the decompression backends of libabw.\n");
+  printf("\n");
+  printf("Usage: abwinflatebench [OPTION] INPUT...\n");
+  printf("\n");
+  printf("Each INPUT must be a compressed AbiWord document (gzip, xz or zstd).\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("\t--help                show this help message\n");
+  printf("\t--iterations N        decompress each document N times (default: 10)\n");
+  return -1;
+}
+
+//! the inflated size stored in the gzip trailer
+unsigned long getInflatedSize(const libabw::AbiMappedFileStream &input)
+{
+  const unsigned char *const data = input.getData();
+  const unsigned long size = input.getSize();
+  if (!data || size < 4 || libabw::ABWDecompressor::detectFormat(data, size) != libabw::ABWDecompressor::FORMAT_GZIP)
+    return 0;
+  const unsigned char *const p = data + size - 4;
+  return (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+bool benchmark(const char *const file, const int iterations)
+{
+  libabw::AbiMappedFileStream input(file);
+  const unsigned long size = getInflatedSize(input);
+  const libabw::ABWDecompressor::Backend backends[] =
+  {
+    libabw::ABWDecompressor::BACKEND_INFLATE,
+    libabw::ABWDecompressor::BACKEND_LIBDEFLATE,
+    libabw::ABWDecompressor::BACKEND_XZ,
+    libabw::ABWDecompressor::BACKEND_ZSTD
+  };
+  const libabw::ABWDecompressor::Format format = libabw::ABWDecompressor::detectFormat(input.getData(), input.getSize());
+
+  printf("%s: %lu bytes\n", file, input.getSize());
+  std::vector<unsigned char> reference;
+  bool ok = true;
+  for (const auto backend : backends)
+  {
+    if (libabw::ABWDecompressor::getFormat(backend) != format)
+      continue;
+    std::unique_ptr<libabw::ABWDecompressor> decompressor(libabw::ABWDecompressor::create(backend));
+    if (!decompressor)
+      continue;
+
+    std::vector<unsigned char> buffer;
+    double best = 0;
+    double total = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      if (!decompressor->decompress(&input, size, buffer, nullptr))
+      {
+        printf("  %-12s failed\n", decompressor->getName());
+        ok = false;
+        break;
+      }
+      const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      total += elapsed;
+      if (i == 0 || elapsed < best)
+        best = elapsed;
+    }
+    if (buffer.empty())
+      continue;
+
+    if (reference.empty())
+      reference.swap(buffer);
+    else if (buffer != reference)
+    {
+      printf("  %-12s produced different data\n", decompressor->getName());
+      ok = false;
+      continue;
+    }
+    printf("  %-12s best %.6fs mean %.6fs %.1f MB/s decompressed\n", decompressor->getName(), best, total / iterations,
+           best > 0 ? double(reference.size()) / best / 1e6 : 0.0);
+  }
+  if (reference.empty())
+  {
+    printf("  no backend for this format\n");
+    ok = false;
+  }
+  return ok;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+  int iterations = 10;
+  std::vector<const char *> files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+    else if (strncmp(argv[i], "--", 2))
+      files.push_back(argv[i]);
+    else
+      return printUsage();
+  }
+
+  if (files.empty() || iterations <= 0)
+    return printUsage();
+
+  bool ok = true;
+  for (const auto file : files)
+    ok = benchmark(file, iterations) && ok;
+  return ok ? 0 : 1;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,172 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <librevenge/librevenge.h>
+#include <librevenge-generators/librevenge-generators.h>
+
+#include <libabw/libabw.h>
+
+namespace
+{
+
+int printUsage()
+{
+  printf("`abwparsebench' compares the XML frontends of libabw.\n");
+  printf("\n");
+  printf("Usage: abwparsebench [OPTION] INPUT...\n");
+  printf("\n");
+  printf("Each INPUT is parsed with xmlTextReader and with SAX2, and the outputs\n");
+  printf("are checked to be the same.\n");
+  printf("\n");
+  printf("Options:\n");
+  printf("\t--data-threads N      decode the embedded data with N threads\n");
+  printf("\t--help                show this help message\n");
+  printf("\t--iterations N        parse each document N times (default: 10)\n");
+  printf("\t--threads N           parse the content of large documents with N threads\n");
+  return -1;
+}
+
+struct Result
+{
+  Result()
+    : m_text()
+    , m_outputElementCount(0)
+    , m_nodeCount(0)
+  {
+  }
+
+  std::string m_text;
+  unsigned long m_outputElementCount;
+  unsigned long m_nodeCount;
+};
+
+bool benchmark(const char *const file, const int iterations, const unsigned threads, const unsigned dataThreads)
+{
+  libabw::AbiMappedFileStream input(file);
+  // the document is decompressed once, so only the parsing is measured
+  const std::unique_ptr<libabw::AbiPreparedDocument> document(libabw::AbiDocument::open(&input));
+  printf("%s: %lu bytes\n", file, input.getSize());
+  if (!document->isSupported())
+  {
+    printf("  not an AbiWord document\n");
+    return false;
+  }
+
+  const struct
+  {
+    libabw::ABWXMLFrontend m_frontend;
+    const char *m_name;
+  } frontends[] =
+  {
+    { libabw::ABW_XML_READER, "reader" },
+    { libabw::ABW_XML_SAX, "sax" }
+  };
+
+  std::unique_ptr<Result> reference;
+  bool ok = true;
+  for (const auto &frontend : frontends)
+  {
+    Result result;
+    double best = 0;
+    double total = 0;
+    double bestStyles = 0;
+    double bestContent = 0;
+    for (int i = 0; i < iterations; ++i)
+    {
+      librevenge::RVNGString text;
+      librevenge::RVNGTextTextGenerator generator(text);
+      libabw::AbiParseStatistics statistics;
+      libabw::AbiParseOptions options;
+      options.m_statistics = &statistics;
+      options.m_xmlFrontend = frontend.m_frontend;
+      options.m_contentThreads = threads;
+      options.m_dataThreads = dataThreads;
+
+      const auto start = std::chrono::steady_clock::now();
+      const libabw::ABWResult parsed = document->parse(&generator, options);
+      const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      if (parsed != libabw::ABW_OK)
+      {
+        printf("  %-8s failed\n", frontend.m_name);
+        ok = false;
+        break;
+      }
+      total += elapsed;
+      if (i == 0 || elapsed < best)
+        best = elapsed;
+      const double styles = statistics.m_wallTime[libabw::AbiParseStatistics::PHASE_STYLES];
+      const double content = statistics.m_wallTime[libabw::AbiParseStatistics::PHASE_CONTENT];
+      if (i == 0 || styles < bestStyles)
+        bestStyles = styles;
+      if (i == 0 || content < bestContent)
+        bestContent = content;
+      if (i == 0)
+      {
+        result.m_text = text.cstr();
+        result.m_outputElementCount = statistics.m_outputElementCount;
+        result.m_nodeCount = statistics.m_nodeCount;
+      }
+    }
+    if (total == 0)
+      continue;
+
+    printf("  %-8s best %.6fs mean %.6fs (styles %.6fs content %.6fs) %lu nodes\n", frontend.m_name, best,
+           total / iterations, bestStyles, bestContent, result.m_nodeCount);
+    if (!reference)
+      reference.reset(new Result(result));
+    else if (result.m_text != reference->m_text || result.m_outputElementCount != reference->m_outputElementCount)
+    {
+      printf("  %-8s produced different output\n", frontend.m_name);
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+  int iterations = 10;
+  unsigned threads = 0;
+  unsigned dataThreads = 0;
+  std::vector<const char *> files;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (!strcmp(argv[i], "--data-threads") && i + 1 < argc)
+      dataThreads = unsigned(atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--iterations") && i + 1 < argc)
+      iterations = atoi(argv[++i]);
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      threads = unsigned(atoi(argv[++i]));
+    else if (strncmp(argv[i], "--", 2))
+      files.push_back(argv[i]);
+    else
+      return printUsage();
+  }
+
+  if (files.empty() || iterations <= 0)
+    return printUsage();
+
+  bool ok = true;
+  for (const auto file : files)
+    ok = benchmark(file, iterations, threads, dataThreads) && ok;
+  return ok ? 0 : 1;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
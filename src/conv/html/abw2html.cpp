@@ -7,6 +7,7 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <memory>
 #include <stdio.h>
 #include <librevenge-stream/librevenge-stream.h>
 #include <librevenge-generators/librevenge-generators.h>
@@ -66,9 +67,10 @@ int main(int argc, char *argv[])
   if (!file)
     return printUsage();
 
-  librevenge::RVNGFileStream input(file);
+  libabw::AbiMappedFileStream input(file);
+  const std::unique_ptr<libabw::AbiPreparedDocument> abiDocument(libabw::AbiDocument::open(&input));
 
-  if (!libabw::AbiDocument::isFileFormatSupported(&input))
+  if (!abiDocument->isSupported())
   {
     fprintf(stderr, "ERROR: Unsupported file format!\n");
     return 1;
@@ -76,7 +78,7 @@ int main(int argc, char *argv[])
 
   librevenge::RVNGString document;
   librevenge::RVNGHTMLTextGenerator documentGenerator(document);
-  if (!libabw::AbiDocument::parse(&input, &documentGenerator))
+  if (!abiDocument->parse(&documentGenerator))
     return 1;
 
   printf("%s", document.cstr());
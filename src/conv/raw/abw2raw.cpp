@@ -7,7 +7,9 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <memory>
 #include <stdio.h>
+#include <stdlib.h>
 #include <librevenge-stream/librevenge-stream.h>
 #include <librevenge-generators/librevenge-generators.h>
 #include <libabw/libabw.h>
@@ -35,7 +37,12 @@ int printUsage()
   printf("\n");
   printf("Options:\n");
   printf("\t--callgraph           display the call graph nesting level\n");
+  printf("\t--data-threads N      decode the embedded data with N threads\n");
   printf("\t--help                show this help message\n");
+  printf("\t--read-ahead          read the file with a background thread\n");
+  printf("\t--sax                 read the XML with the SAX2 interface of libxml2\n");
+  printf("\t--stats               print parse timings and counters to stderr\n");
+  printf("\t--threads N           parse the content of large documents with N threads\n");
   printf("\t--version             show version information\n");
   printf("\n");
   printf("Report bugs to <https://bugs.documentfoundation.org/>.\n");
@@ -48,11 +55,35 @@ int printVersion()
   return 0;
 }
 
+void printStatistics(const libabw::AbiParseStatistics &stats)
+{
+  const char *const phases[] = { "decompression", "styles", "content", "output" };
+  for (int i = 0; i < libabw::AbiParseStatistics::PHASE_COUNT; ++i)
+    fprintf(stderr, "%-14s wall %.6fs cpu %.6fs\n", phases[i], stats.m_wallTime[i], stats.m_cpuTime[i]);
+  fprintf(stderr, "inflated bytes:          %lu\n", stats.m_inflatedBytes);
+  fprintf(stderr, "nodes:                   %lu\n", stats.m_nodeCount);
+  fprintf(stderr, "unknown elements:        %lu\n", stats.m_unknownElementCount);
+  fprintf(stderr, "attribute bytes:         %lu\n", stats.m_attributeBytes);
+  fprintf(stderr, "base64 decoded bytes:    %lu\n", stats.m_base64DecodedBytes);
+  fprintf(stderr, "output elements:         %lu\n", stats.m_outputElementCount);
+  fprintf(stderr, "peak buffered elements:  %lu\n", stats.m_peakBufferedElements);
+  fprintf(stderr, "content parts:           %lu\n", stats.m_contentPartCount);
+  fprintf(stderr, "reparsed content parts:  %lu\n", stats.m_reparsedContentPartCount);
+  librevenge::RVNGPropertyList::Iter count(stats.m_elementCounts);
+  for (count.rewind(); count.next();)
+    fprintf(stderr, "<%s>: %d\n", count.key(), count()->getInt());
+}
+
 } // anonymous namespace
 
 int main(int argc, char *argv[])
 {
   bool printIndentLevel = false;
+  bool printStats = false;
+  bool readAhead = false;
+  bool sax = false;
+  unsigned threads = 0;
+  unsigned dataThreads = 0;
   char *file = nullptr;
 
   if (argc < 2)
@@ -62,6 +93,16 @@ int main(int argc, char *argv[])
   {
     if (!strcmp(argv[i], "--callgraph"))
       printIndentLevel = true;
+    else if (!strcmp(argv[i], "--data-threads") && i + 1 < argc)
+      dataThreads = unsigned(atoi(argv[++i]));
+    else if (!strcmp(argv[i], "--read-ahead"))
+      readAhead = true;
+    else if (!strcmp(argv[i], "--sax"))
+      sax = true;
+    else if (!strcmp(argv[i], "--stats"))
+      printStats = true;
+    else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+      threads = unsigned(atoi(argv[++i]));
     else if (!strcmp(argv[i], "--version"))
       return printVersion();
     else if (!file && strncmp(argv[i], "--", 2))
@@ -73,17 +114,38 @@ int main(int argc, char *argv[])
   if (!file)
     return printUsage();
 
-  librevenge::RVNGFileStream input(file);
+  std::unique_ptr<librevenge::RVNGInputStream> fileInput;
+  std::unique_ptr<librevenge::RVNGInputStream> input;
+  if (readAhead)
+  {
+    fileInput.reset(new librevenge::RVNGFileStream(file));
+    input.reset(new libabw::AbiReadAheadStream(fileInput.get()));
+  }
+  else
+  {
+    input.reset(new libabw::AbiMappedFileStream(file));
+  }
+
+  libabw::AbiParseStatistics stats;
+  libabw::AbiParseOptions options;
+  if (printStats)
+    options.m_statistics = &stats;
+  if (sax)
+    options.m_xmlFrontend = libabw::ABW_XML_SAX;
+  options.m_contentThreads = threads;
+  options.m_dataThreads = dataThreads;
+  const std::unique_ptr<libabw::AbiPreparedDocument> abiDocument(libabw::AbiDocument::open(input.get(), options));
 
-  if (!libabw::AbiDocument::isFileFormatSupported(&input))
+  if (!abiDocument->isSupported())
   {
     fprintf(stderr, "ERROR: Unsupported file format!\n");
     return 1;
   }
 
   librevenge::RVNGRawTextGenerator documentGenerator(printIndentLevel);
-  if (libabw::AbiDocument::parse(&input, &documentGenerator))
-    return 0;
-  return 1;
+  const bool ok = abiDocument->parse(&documentGenerator, options) == libabw::ABW_OK;
+  if (printStats)
+    printStatistics(stats);
+  return ok ? 0 : 1;
 }
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
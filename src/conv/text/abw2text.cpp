@@ -8,6 +8,7 @@
  */
 
 
+#include <memory>
 #include <stdio.h>
 #include <string.h>
 #include <librevenge-stream/librevenge-stream.h>
@@ -71,9 +72,10 @@ int main(int argc, char *argv[])
   if (!szInputFile)
     return printUsage();
 
-  librevenge::RVNGFileStream input(szInputFile);
+  libabw::AbiMappedFileStream input(szInputFile);
+  const std::unique_ptr<libabw::AbiPreparedDocument> abiDocument(libabw::AbiDocument::open(&input));
 
-  if (!libabw::AbiDocument::isFileFormatSupported(&input))
+  if (!abiDocument->isSupported())
   {
     fprintf(stderr, "ERROR: Unsupported file format!\n");
     return 1;
@@ -81,7 +83,7 @@ int main(int argc, char *argv[])
 
   librevenge::RVNGString document;
   librevenge::RVNGTextTextGenerator documentGenerator(document, isInfo);
-  if (!libabw::AbiDocument::parse(&input, &documentGenerator))
+  if (!abiDocument->parse(&documentGenerator))
     return 1;
 
   printf("%s", document.cstr());
@@ -7,6 +7,12 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <algorithm>
+#include <cmath>
+#include <locale>
+#include <sstream>
+#include <string.h>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/optional.hpp>
 #include <boost/spirit/include/qi.hpp>
@@ -42,6 +48,45 @@ void libabw::parsePropString(const std::string &str, ABWPropertyMap &props)
   }
 }
 
+void libabw::findProperties(const char *const props, const char *const names[], std::string values[], const std::size_t count)
+{
+  for (std::size_t i = 0; i < count; ++i)
+    values[i].clear();
+  if (!props)
+    return;
+
+  // the same classification as boost::algorithm::is_space()
+  const std::ctype<char> &ctype = std::use_facet<std::ctype<char>>(std::locale());
+  const char *begin = props;
+  while (*begin)
+  {
+    const char *end = begin;
+    while (*end && *end != ';')
+      ++end;
+    const char *const next = *end ? end + 1 : end;
+
+    while (begin != end && ctype.is(std::ctype_base::space, *begin))
+      ++begin;
+    while (end != begin && ctype.is(std::ctype_base::space, end[-1]))
+      --end;
+    const char *const separator = std::find(begin, end, ':');
+    const char *value = separator;
+    while (value != end && *value == ':')
+      ++value;
+    // an entry with more than one separator is ignored; the last entry for a name wins
+    if (separator != end && std::find(value, end, ':') == end)
+    {
+      const auto length = std::size_t(separator - begin);
+      for (std::size_t i = 0; i < count; ++i)
+      {
+        if (strncmp(names[i], begin, length) == 0 && names[i][length] == '\0')
+          values[i].assign(value, end);
+      }
+    }
+    begin = next;
+  }
+}
+
 bool libabw::findDouble(const std::string &str, double &res, ABWUnit &unit)
 {
   using namespace boost::spirit::qi;
@@ -80,6 +125,91 @@ bool libabw::findDouble(const std::string &str, double &res, ABWUnit &unit)
   return true;
 }
 
+std::string libabw::formatDouble(double value)
+{
+  std::string result;
+  if (value < 0)
+  {
+    result += '-';
+    value = -value;
+  }
+  if (value == 0)
+    return result + '0';
+
+  // find the 6 significant digits
+  int exponent = 0;
+  long long mantissa = 0;
+  if (std::isfinite(value))
+  {
+    exponent = int(std::floor(std::log10(value)));
+    for (int i = 0; i < 3; ++i)
+    {
+      const double scaled = value * std::pow(10.0, 5 - exponent);
+      if (!std::isfinite(scaled))
+        break;
+      if (std::fabs(scaled - std::floor(scaled) - 0.5) < 1e-6)
+      {
+        // too close to a tie to round correctly here
+        mantissa = 0;
+        break;
+      }
+      mantissa = std::llround(scaled);
+      if (mantissa >= 1000000)
+        ++exponent;
+      else if (mantissa < 100000)
+        --exponent;
+      else
+        break;
+    }
+  }
+  if (mantissa < 100000 || mantissa >= 1000000)
+  {
+    // infinity, a subnormal number or a tie: take the slow path
+    std::ostringstream s;
+    s.imbue(std::locale::classic());
+    s << value;
+    return result + s.str();
+  }
+
+  char digits[6];
+  for (int i = 5; i >= 0; --i, mantissa /= 10)
+    digits[i] = char('0' + mantissa % 10);
+  int last = 5;
+  while (last > 0 && digits[last] == '0')
+    --last;
+
+  if (exponent < -4 || exponent >= 6)
+  {
+    result += digits[0];
+    if (last > 0)
+    {
+      result += '.';
+      result.append(digits + 1, digits + last + 1);
+    }
+    result += exponent < 0 ? "e-" : "e+";
+    const int absExponent = exponent < 0 ? -exponent : exponent;
+    if (absExponent < 10)
+      result += '0';
+    result += std::to_string(absExponent);
+  }
+  else if (exponent >= 0)
+  {
+    result.append(digits, digits + exponent + 1);
+    if (last > exponent)
+    {
+      result += '.';
+      result.append(digits + exponent + 1, digits + last + 1);
+    }
+  }
+  else
+  {
+    result += "0.";
+    result.append(std::size_t(-exponent - 1), '0');
+    result.append(digits, digits + last + 1);
+  }
+  return result;
+}
+
 void libabw::ABWListElement::writeOut(librevenge::RVNGPropertyList &propList) const
 {
   if (m_listLevel > 0)
@@ -106,4 +236,57 @@ void libabw::ABWUnorderedListElement::writeOut(librevenge::RVNGPropertyList &pro
   propList.insert("text:bullet-char", m_bulletChar);
 }
 
+libabw::ABWListTable::Entry::Entry(const int id, const std::shared_ptr<ABWListElement> &element)
+  : m_id(id), m_element(element), m_parent(nullptr), m_propList()
+{
+}
+
+libabw::ABWListTable::ABWListTable()
+  : m_entries(), m_dummyElement(std::make_shared<ABWUnorderedListElement>()), m_dummyPropLists(MAX_LIST_LEVEL + 1)
+{
+  for (int level = 0; level <= MAX_LIST_LEVEL; ++level)
+  {
+    m_dummyElement->m_listLevel = level;
+    m_dummyElement->writeOut(m_dummyPropLists[std::size_t(level)]);
+  }
+  m_dummyElement->m_listLevel = -1;
+}
+
+void libabw::ABWListTable::build(const std::map<int, std::shared_ptr<ABWListElement>> &listElements)
+{
+  m_entries.clear();
+  m_entries.reserve(listElements.size());
+  // the map is sorted by id already
+  for (const auto &listElement : listElements)
+  {
+    if (listElement.second)
+      m_entries.push_back(Entry(listElement.first, listElement.second));
+  }
+  for (auto &entry : m_entries)
+  {
+    if (entry.m_element->m_parentId)
+      entry.m_parent = find(entry.m_element->m_parentId);
+    entry.m_element->writeOut(entry.m_propList);
+    // osnola: use the element list id if set, if not use the id
+    entry.m_propList.insert("librevenge:list-id", entry.m_element->m_listId ? entry.m_element->m_listId : entry.m_id);
+  }
+}
+
+const libabw::ABWListTable::Entry *libabw::ABWListTable::find(const int id) const
+{
+  const auto it = std::lower_bound(m_entries.begin(), m_entries.end(), id,
+                                   [](const Entry &entry, const int value)
+  {
+    return entry.m_id < value;
+  });
+  if (it == m_entries.end() || it->m_id != id)
+    return nullptr;
+  return &*it;
+}
+
+const librevenge::RVNGPropertyList &libabw::ABWListTable::getDummyPropList(const int level) const
+{
+  return m_dummyPropLists[std::size_t(std::min(std::max(level, 0), MAX_LIST_LEVEL))];
+}
+
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
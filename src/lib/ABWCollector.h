@@ -12,8 +12,12 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <vector>
 #include <librevenge/librevenge.h>
 
+#define MAX_LIST_LEVEL 64 // a safeguard against damaged files
+
 namespace libabw
 {
 class ABWOutputElements;
@@ -40,7 +44,15 @@ typedef std::map<std::string, std::string> ABWPropertyMap;
 
 bool findInt(const std::string &str, int &res);
 bool findDouble(const std::string &str, double &res, ABWUnit &unit);
+//! format a double like "%g" in the C locale, independently of the current locale
+std::string formatDouble(double value);
 void parsePropString(const std::string &str, ABWPropertyMap &props);
+/** Find the values of some properties of a props string, as parsePropString()
+    would, without building the whole map.
+
+    The values of the properties that are not found are empty.
+  */
+void findProperties(const char *props, const char *const names[], std::string values[], std::size_t count);
 
 struct ABWData
 {
@@ -104,6 +116,52 @@ struct ABWUnorderedListElement : public ABWListElement
   librevenge::RVNGString m_bulletChar;
 };
 
+/** The list definitions of a document, for the content pass.
+
+    The definitions are kept in a flat table sorted by id, together with
+    their precomputed property lists. Levels without a definition share
+    a single dummy element.
+  */
+class ABWListTable
+{
+public:
+  struct Entry
+  {
+    Entry(int id, const std::shared_ptr<ABWListElement> &element);
+    Entry(const Entry &entry) = default;
+    Entry &operator=(const Entry &entry) = default;
+
+    int m_id;
+    std::shared_ptr<ABWListElement> m_element;
+    //! the parent entry, or nullptr
+    const Entry *m_parent;
+    //! the properties of the list level
+    librevenge::RVNGPropertyList m_propList;
+  };
+
+  ABWListTable();
+
+  void build(const std::map<int, std::shared_ptr<ABWListElement>> &listElements);
+
+  //! get the definition of a list, or nullptr if there is none
+  const Entry *find(int id) const;
+
+  const std::shared_ptr<ABWListElement> &getDummyElement() const
+  {
+    return m_dummyElement;
+  }
+  //! get the properties of a dummy level, level <= MAX_LIST_LEVEL
+  const librevenge::RVNGPropertyList &getDummyPropList(int level) const;
+
+private:
+  ABWListTable(const ABWListTable &);
+  ABWListTable &operator=(const ABWListTable &);
+
+  std::vector<Entry> m_entries;
+  std::shared_ptr<ABWListElement> m_dummyElement;
+  std::vector<librevenge::RVNGPropertyList> m_dummyPropLists;
+};
+
 class ABWCollector
 {
 public:
@@ -155,6 +213,20 @@ public:
   virtual void addFrameElements(ABWOutputElements &elements, bool pageFrame) = 0;
 
   virtual void addMetadataEntry(const char *name, const char *value) = 0;
+
+  /** Whether nothing in the elements with this token concerns the
+      collector, so the parser may skip them with their contents.
+    */
+  virtual bool isElementIgnored(int /* tokenId */) const
+  {
+    return false;
+  }
+
+  //! Whether the collector needs nothing more of the document, so the parser may stop.
+  virtual bool isFinished() const
+  {
+    return false;
+  }
 };
 
 } // namespace libabw
@@ -11,20 +11,21 @@
 #include "config.h"
 #endif
 
+#include <algorithm>
 #include <cassert>
-#include <locale>
 #include <memory>
-#include <sstream>
 
 #include <boost/spirit/include/qi.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/optional.hpp>
 #include <librevenge/librevenge.h>
 #include "ABWContentCollector.h"
+#include "ABWParseControl.h"
+#include "ABWValueMap.h"
 #include "libabw_internal.h"
+#include "tokens.h"
 
 #define ABW_EPSILON 1.0E-06
-#define MAX_LIST_LEVEL 64 // a safeguard against damaged files
 #define MAX_TABLE_ROW (1 << 16) // a safeguard against damaged top-attach
 
 using boost::optional;
@@ -300,22 +301,6 @@ libabw::ABWContentTableState::ABWContentTableState() :
 {
 }
 
-libabw::ABWContentTableState::ABWContentTableState(const ABWContentTableState &ts) :
-  m_currentTableProperties(ts.m_currentTableProperties),
-  m_currentCellProperties(ts.m_currentCellProperties),
-
-  m_currentTableCol(ts.m_currentTableCol),
-  m_currentTableRow(ts.m_currentTableRow),
-  m_currentTableCellNumberInRow(ts.m_currentTableCellNumberInRow),
-  m_currentTableId(ts.m_currentTableId),
-  m_isTableRowOpened(ts.m_isTableRowOpened),
-  m_isTableColumnOpened(ts.m_isTableColumnOpened),
-  m_isTableCellOpened(ts.m_isTableCellOpened),
-  m_isCellWithoutParagraph(ts.m_isCellWithoutParagraph),
-  m_isRowWithoutCell(ts.m_isRowWithoutCell)
-{
-}
-
 libabw::ABWContentTableState::~ABWContentTableState()
 {
 }
@@ -369,65 +354,185 @@ libabw::ABWContentParsingState::ABWContentParsingState() :
 {
 }
 
-libabw::ABWContentParsingState::ABWContentParsingState(const ABWContentParsingState &ps) :
-  m_isDocumentStarted(ps.m_isDocumentStarted),
-  m_isPageSpanOpened(ps.m_isPageSpanOpened),
-  m_isSectionOpened(ps.m_isSectionOpened),
-  m_isHeaderOpened(ps.m_isHeaderOpened),
-  m_isFooterOpened(ps.m_isFooterOpened),
-
-  m_isPageFrame(ps.m_isPageFrame),
-
-  m_isSpanOpened(ps.m_isSpanOpened),
-  m_isParagraphOpened(ps.m_isParagraphOpened),
-  m_isListElementOpened(ps.m_isListElementOpened),
-  m_inParagraphOrListElement(ps.m_inParagraphOrListElement),
-
-  m_currentSectionStyle(ps.m_currentSectionStyle),
-  m_currentParagraphStyle(ps.m_currentParagraphStyle),
-  m_currentCharacterStyle(ps.m_currentCharacterStyle),
-
-  m_pageWidth(ps.m_pageWidth),
-  m_pageHeight(ps.m_pageHeight),
-  m_pageMarginTop(ps.m_pageMarginTop),
-  m_pageMarginBottom(ps.m_pageMarginBottom),
-  m_pageMarginLeft(ps.m_pageMarginLeft),
-  m_pageMarginRight(ps.m_pageMarginRight),
-  m_footerId(ps.m_footerId),
-  m_footerLeftId(ps.m_footerLeftId),
-  m_footerFirstId(ps.m_footerFirstId),
-  m_footerLastId(ps.m_footerLastId),
-  m_headerId(ps.m_headerId),
-  m_headerLeftId(ps.m_headerLeftId),
-  m_headerFirstId(ps.m_headerFirstId),
-  m_headerLastId(ps.m_headerLastId),
-  m_currentHeaderFooterId(ps.m_currentHeaderFooterId),
-  m_currentHeaderFooterOccurrence(ps.m_currentHeaderFooterOccurrence),
-  m_parsingContext(ps.m_parsingContext),
-
-  m_deferredPageBreak(ps.m_deferredPageBreak),
-  m_deferredColumnBreak(ps.m_deferredColumnBreak),
-
-  m_isNote(ps.m_isNote),
-  m_currentListLevel(ps.m_currentListLevel),
-  m_currentListId(ps.m_currentListId),
-  m_isFirstTextInListElement(ps.m_isFirstTextInListElement),
-
-  m_tableStates(ps.m_tableStates),
-  m_listLevels(ps.m_listLevels)
+libabw::ABWContentParsingState::~ABWContentParsingState()
 {
 }
 
-libabw::ABWContentParsingState::~ABWContentParsingState()
+void libabw::ABWContentParsingState::clear()
+{
+  m_isDocumentStarted = false;
+  m_isPageSpanOpened = false;
+  m_isSectionOpened = false;
+  m_isHeaderOpened = false;
+  m_isFooterOpened = false;
+
+  m_isPageFrame = false;
+
+  m_isSpanOpened = false;
+  m_isParagraphOpened = false;
+  m_isListElementOpened = false;
+  m_inParagraphOrListElement = false;
+
+  m_currentSectionStyle.clear();
+  m_currentParagraphStyle.clear();
+  m_currentCharacterStyle.clear();
+
+  m_pageWidth = 0.0;
+  m_pageHeight = 0.0;
+  m_pageMarginTop = 0.0;
+  m_pageMarginBottom = 0.0;
+  m_pageMarginLeft = 0.0;
+  m_pageMarginRight = 0.0;
+  m_footerId = -1;
+  m_footerLeftId = -1;
+  m_footerFirstId = -1;
+  m_footerLastId = -1;
+  m_headerId = -1;
+  m_headerLeftId = -1;
+  m_headerFirstId = -1;
+  m_headerLastId = -1;
+  m_currentHeaderFooterId = -1;
+  m_currentHeaderFooterOccurrence.clear();
+  m_parsingContext = ABW_SECTION;
+
+  m_deferredPageBreak = false;
+  m_deferredColumnBreak = false;
+
+  m_isNote = false;
+  m_currentListLevel = 0;
+  m_currentListId = 0;
+  m_isFirstTextInListElement = false;
+
+  while (!m_tableStates.empty())
+    m_tableStates.pop();
+  while (!m_listLevels.empty())
+    m_listLevels.pop();
+}
+
+void libabw::ABWContentParsingState::assign(const ABWContentParsingState &state)
+{
+  m_isDocumentStarted = state.m_isDocumentStarted;
+  m_isPageSpanOpened = state.m_isPageSpanOpened;
+  m_isSectionOpened = state.m_isSectionOpened;
+  m_isHeaderOpened = state.m_isHeaderOpened;
+  m_isFooterOpened = state.m_isFooterOpened;
+
+  m_isPageFrame = state.m_isPageFrame;
+
+  m_isSpanOpened = state.m_isSpanOpened;
+  m_isParagraphOpened = state.m_isParagraphOpened;
+  m_isListElementOpened = state.m_isListElementOpened;
+  m_inParagraphOrListElement = state.m_inParagraphOrListElement;
+
+  m_currentSectionStyle = state.m_currentSectionStyle;
+  m_currentParagraphStyle = state.m_currentParagraphStyle;
+  m_currentCharacterStyle = state.m_currentCharacterStyle;
+
+  m_pageWidth = state.m_pageWidth;
+  m_pageHeight = state.m_pageHeight;
+  m_pageMarginTop = state.m_pageMarginTop;
+  m_pageMarginBottom = state.m_pageMarginBottom;
+  m_pageMarginLeft = state.m_pageMarginLeft;
+  m_pageMarginRight = state.m_pageMarginRight;
+  m_footerId = state.m_footerId;
+  m_footerLeftId = state.m_footerLeftId;
+  m_footerFirstId = state.m_footerFirstId;
+  m_footerLastId = state.m_footerLastId;
+  m_headerId = state.m_headerId;
+  m_headerLeftId = state.m_headerLeftId;
+  m_headerFirstId = state.m_headerFirstId;
+  m_headerLastId = state.m_headerLastId;
+  m_currentHeaderFooterId = state.m_currentHeaderFooterId;
+  m_currentHeaderFooterOccurrence = state.m_currentHeaderFooterOccurrence;
+  m_parsingContext = state.m_parsingContext;
+
+  m_deferredPageBreak = state.m_deferredPageBreak;
+  m_deferredColumnBreak = state.m_deferredColumnBreak;
+
+  m_isNote = state.m_isNote;
+  m_currentListLevel = state.m_currentListLevel;
+  m_currentListId = state.m_currentListId;
+  m_isFirstTextInListElement = state.m_isFirstTextInListElement;
+
+  while (!m_tableStates.empty())
+    m_tableStates.pop();
+  m_listLevels = state.m_listLevels;
+}
+
+bool libabw::ABWContentParsingState::isSame(const ABWContentParsingState &state) const
+{
+  // starting the document has no effect on what is collected, once it is started
+  return (m_isDocumentStarted || !state.m_isDocumentStarted) &&
+         m_isPageSpanOpened == state.m_isPageSpanOpened &&
+         m_isSectionOpened == state.m_isSectionOpened &&
+         m_isHeaderOpened == state.m_isHeaderOpened &&
+         m_isFooterOpened == state.m_isFooterOpened &&
+
+         m_isPageFrame == state.m_isPageFrame &&
+
+         m_isSpanOpened == state.m_isSpanOpened &&
+         m_isParagraphOpened == state.m_isParagraphOpened &&
+         m_isListElementOpened == state.m_isListElementOpened &&
+         m_inParagraphOrListElement == state.m_inParagraphOrListElement &&
+
+         m_currentSectionStyle == state.m_currentSectionStyle &&
+         m_currentParagraphStyle == state.m_currentParagraphStyle &&
+         m_currentCharacterStyle == state.m_currentCharacterStyle &&
+
+         m_pageWidth == state.m_pageWidth &&
+         m_pageHeight == state.m_pageHeight &&
+         m_pageMarginTop == state.m_pageMarginTop &&
+         m_pageMarginBottom == state.m_pageMarginBottom &&
+         m_pageMarginLeft == state.m_pageMarginLeft &&
+         m_pageMarginRight == state.m_pageMarginRight &&
+         m_footerId == state.m_footerId &&
+         m_footerLeftId == state.m_footerLeftId &&
+         m_footerFirstId == state.m_footerFirstId &&
+         m_footerLastId == state.m_footerLastId &&
+         m_headerId == state.m_headerId &&
+         m_headerLeftId == state.m_headerLeftId &&
+         m_headerFirstId == state.m_headerFirstId &&
+         m_headerLastId == state.m_headerLastId &&
+         m_currentHeaderFooterId == state.m_currentHeaderFooterId &&
+         m_currentHeaderFooterOccurrence == state.m_currentHeaderFooterOccurrence &&
+         m_parsingContext == state.m_parsingContext &&
+
+         m_deferredPageBreak == state.m_deferredPageBreak &&
+         m_deferredColumnBreak == state.m_deferredColumnBreak &&
+
+         m_isNote == state.m_isNote &&
+         m_currentListLevel == state.m_currentListLevel &&
+         // the list id is set together with a level above 0, before it is used
+         (m_currentListLevel == 0 || m_currentListId == state.m_currentListId) &&
+         m_isFirstTextInListElement == state.m_isFirstTextInListElement &&
+
+         m_tableStates.empty() && state.m_tableStates.empty() &&
+         m_listLevels == state.m_listLevels;
+}
+
+libabw::ABWContentSectionState::ABWContentSectionState()
+  : m_ps()
+  , m_tableCounter(0)
+  , m_textStyles()
+  , m_documentStyle()
+  , m_metadata()
+{
+}
+
+libabw::ABWContentSectionState::~ABWContentSectionState()
 {
 }
 
 libabw::ABWContentCollector::ABWContentCollector(librevenge::RVNGTextInterface *iface, const std::map<int, int> &tableSizes,
                                                  const std::map<std::string, ABWData> &data,
-                                                 const std::map<int, std::shared_ptr<ABWListElement>> &listElements) :
+                                                 const ABWListTable &listTable,
+                                                 AbiParseStatistics *statistics, ABWParseControl *control) :
   m_ps(new ABWContentParsingState),
   m_iface(iface),
+  m_statistics(statistics),
+  m_control(control),
   m_parsingStates(),
+  m_parsingStatePool(),
   m_dontLoop(),
   m_textStyles(),
   m_documentStyle(),
@@ -435,10 +540,15 @@ libabw::ABWContentCollector::ABWContentCollector(librevenge::RVNGTextInterface *
   m_data(data),
   m_tableSizes(tableSizes),
   m_tableCounter(0),
-  m_outputElements(),
-  m_pageOutputElements(),
-  m_listElements(listElements),
-  m_dummyListElements()
+  m_outputElements(control),
+  m_pageOutputElements(control),
+  m_listTable(listTable),
+  m_borderCache(),
+  m_fieldProperties(),
+  m_languages(),
+  m_decodedUrls(),
+  m_frameContexts(),
+  m_frameOutputPool()
 {
 }
 
@@ -523,11 +633,6 @@ std::string libabw::ABWContentCollector::_findCharacterProperty(const char *name
   return prop;
 }
 
-std::string libabw::ABWContentCollector::_findMetadataEntry(const char *const name)
-{
-  return findProperty(m_metadata, name);
-}
-
 void libabw::ABWContentCollector::collectDocumentProperties(const char *const props)
 {
   if (props)
@@ -538,18 +643,19 @@ void libabw::ABWContentCollector::_addBorderProperties(const std::map<std::strin
 {
   int setBorders=0;
   static char const *odtWh[4]= {"fo:border-left", "fo:border-right", "fo:border-top", "fo:border-bottom"};
+  static const std::string colorKeys[4]= {"left-color", "right-color", "top-color", "bot-color"};
+  static const std::string styleKeys[4]= {"left-style", "right-style", "top-style", "bot-style"};
+  static const std::string thicknessKeys[4]= {"left-thickness", "right-thickness", "top-thickness", "bot-thickness"};
   for (int i=0, depl=1; i<4; ++i, depl*=2)
   {
-    static char const *wh[4]= {"left", "right", "top", "bot"};
-    std::string whString(wh[i]);
-    std::string tmp=whString+"-color";
-    if (map.find(tmp)==map.end()) continue;
-    std::string color=getColor(map.find(tmp)->second);
+    auto it=map.find(colorKeys[i]);
+    if (it==map.end()) continue;
+    std::string color=getColor(it->second);
     if (color.empty())
       continue;
     int style;
-    tmp=whString+"-style";
-    if (map.find(tmp)==map.end() || !findInt(map.find(tmp)->second, style))
+    it=map.find(styleKeys[i]);
+    if (it==map.end() || !findInt(it->second, style))
       style=1;
     else if (style<=0 || style>=4)
     {
@@ -558,19 +664,24 @@ void libabw::ABWContentCollector::_addBorderProperties(const std::map<std::strin
     }
     ABWUnit unit(ABW_NONE);
     double width(0.0);
-    tmp=whString+"-thickness";
-    if (map.find(tmp)==map.end() || !findDouble(map.find(tmp)->second, width, unit))
+    it=map.find(thicknessKeys[i]);
+    if (it==map.end() || !findDouble(it->second, width, unit))
       width=0.01;
     else if (width<=0 || unit != ABW_IN)
       continue;
-    std::stringstream s;
-    s.imbue(std::locale("C")); // be sure that we use standart double
-    s << width << "in ";
-    if (style==2) s << "dotted ";
-    else if (style==3) s << "dashed ";
-    else s << "solid ";
-    s << color;
-    propList.insert(odtWh[i], s.str().c_str());
+    if (style!=2 && style!=3)
+      style=1;
+    auto &border=m_borderCache[std::make_tuple(width, style, color)];
+    if (border.empty())
+    {
+      std::string s(formatDouble(width));
+      if (style==2) s+="in dotted ";
+      else if (style==3) s+="in dashed ";
+      else s+="in solid ";
+      s+=color;
+      border=s.c_str();
+    }
+    propList.insert(odtWh[i], border);
     setBorders|=depl;
   }
   if (defaultUndefBorderProp.empty()) return;
@@ -820,8 +931,17 @@ void libabw::ABWContentCollector::endDocument()
 
     if (m_iface)
     {
-      m_pageOutputElements.write(m_iface);
-      m_outputElements.write(m_iface);
+      if (m_statistics)
+      {
+        // the output is only released after it has been replayed, so this is the peak
+        const unsigned long buffered = (unsigned long)(m_pageOutputElements.size() + m_outputElements.size());
+        m_statistics->m_outputElementCount += buffered;
+        if (buffered > m_statistics->m_peakBufferedElements)
+          m_statistics->m_peakBufferedElements = buffered;
+      }
+      ABWPhaseTimer timer(m_statistics, AbiParseStatistics::PHASE_OUTPUT);
+      m_pageOutputElements.write(m_iface, m_control);
+      m_outputElements.write(m_iface, m_control);
       m_iface->endDocument();
     }
   }
@@ -830,23 +950,29 @@ void libabw::ABWContentCollector::endDocument()
 void libabw::ABWContentCollector::_setMetadata()
 {
   librevenge::RVNGPropertyList propList;
+  convertMetadata(m_metadata, propList);
+  if (m_iface)
+    m_iface->setDocumentMetaData(propList);
+}
 
+void libabw::ABWContentCollector::convertMetadata(const ABWPropertyMap &metadata, librevenge::RVNGPropertyList &propList)
+{
   const std::string dcKeys[] = { "language", "publisher", "source", "subject", "title", "type" };
 
   for (std::size_t i = 0; i != ABW_NUM_ELEMENTS(dcKeys); ++i)
   {
     const std::string abwKey = "dc." + dcKeys[i];
     const std::string rvngKey = "dc:" + dcKeys[i];
-    const std::string prop = _findMetadataEntry(abwKey.c_str());
+    const std::string prop = findProperty(metadata, abwKey.c_str());
     if (!prop.empty())
       propList.insert(rvngKey.c_str(), prop.c_str());
   }
 
-  std::string prop = _findMetadataEntry("abiword.keywords");
+  std::string prop = findProperty(metadata, "abiword.keywords");
   if (!prop.empty())
     propList.insert("meta:keyword", prop.c_str());
 
-  prop = _findMetadataEntry("dc.creator");
+  prop = findProperty(metadata, "dc.creator");
   if (!prop.empty())
     propList.insert("meta:initial-creator", prop.c_str());
 
@@ -857,8 +983,65 @@ void libabw::ABWContentCollector::_setMetadata()
 #endif
   std::string generator = "libabw/" + version;
   propList.insert("meta:generator", generator.c_str());
-  if (m_iface)
-    m_iface->setDocumentMetaData(propList);
+}
+
+bool libabw::ABWContentCollector::isBetweenSections() const
+{
+  return m_parsingStates.empty() && m_frameContexts.empty() && m_ps->m_tableStates.empty() && !m_ps->m_isNote
+         && !m_ps->m_inParagraphOrListElement && m_outputElements.isInBody() && m_pageOutputElements.isInBody();
+}
+
+void libabw::ABWContentCollector::saveSectionState(ABWContentSectionState &state) const
+{
+  state.m_ps.assign(*m_ps);
+  state.m_tableCounter = m_tableCounter;
+  state.m_textStyles = m_textStyles;
+  state.m_documentStyle = m_documentStyle;
+  state.m_metadata = m_metadata;
+}
+
+bool libabw::ABWContentCollector::canAppendSections(const ABWContentSectionState &state, const ABWContentCollector &collector) const
+{
+  const auto isSameStyle = [](const std::pair<const std::string, ABWStyle> &left, const std::pair<const std::string, ABWStyle> &right)
+  {
+    return left.first == right.first && left.second.basedon == right.second.basedon
+           && left.second.followedby == right.second.followedby && left.second.properties == right.second.properties;
+  };
+  // if collector starts the document, it must be with the same metadata
+  return isBetweenSections() && m_ps->isSame(state.m_ps) && m_tableCounter == state.m_tableCounter
+         && m_textStyles.size() == state.m_textStyles.size()
+         && std::equal(m_textStyles.begin(), m_textStyles.end(), state.m_textStyles.begin(), isSameStyle)
+         && m_documentStyle == state.m_documentStyle && m_metadata == state.m_metadata
+         && collector.m_metadata == state.m_metadata;
+}
+
+void libabw::ABWContentCollector::appendSections(ABWContentCollector &collector)
+{
+  if (collector.m_ps->m_isDocumentStarted)
+    startDocument();
+  if (m_control)
+    m_control->addOutputElements((unsigned long)(collector.m_outputElements.size() + collector.m_pageOutputElements.size()));
+  m_outputElements.spliceAll(collector.m_outputElements);
+  m_pageOutputElements.spliceAll(collector.m_pageOutputElements);
+
+  const bool isDocumentStarted = m_ps->m_isDocumentStarted;
+  m_ps.swap(collector.m_ps);
+  m_ps->m_isDocumentStarted = m_ps->m_isDocumentStarted || isDocumentStarted;
+  m_tableCounter = collector.m_tableCounter;
+  m_textStyles.swap(collector.m_textStyles);
+  m_documentStyle.swap(collector.m_documentStyle);
+  m_metadata.swap(collector.m_metadata);
+}
+
+void libabw::ABWContentCollector::skipTables(const int count)
+{
+  m_tableCounter += count;
+}
+
+void libabw::ABWContentCollector::clearOutput()
+{
+  m_outputElements.clear();
+  m_pageOutputElements.clear();
 }
 
 void libabw::ABWContentCollector::endSection()
@@ -887,7 +1070,12 @@ void libabw::ABWContentCollector::openLink(const char *href)
   _openBlock();
   librevenge::RVNGPropertyList propList;
   if (href)
-    propList.insert("xlink:href", decodeUrl(href).c_str());
+  {
+    auto it = m_decodedUrls.find(href);
+    if (it == m_decodedUrls.end())
+      it = m_decodedUrls.insert(std::make_pair(std::string(href), librevenge::RVNGString(decodeUrl(href).c_str()))).first;
+    propList.insert("xlink:href", it->second);
+  }
   m_outputElements.addOpenLink(propList);
   if (!m_ps->m_isSpanOpened)
     _openSpan();
@@ -1297,20 +1485,22 @@ void libabw::ABWContentCollector::_openSpan()
     boost::split(listDecorations, sValue, boost::is_any_of(" "), boost::token_compress_on);
     for (const auto &decoration : listDecorations)
     {
-      if (decoration == "underline")
+      switch (ABWValueMap::getValueId(decoration))
       {
+      case VALUE_UNDERLINE:
         propList.insert("style:text-underline-type", "single");
         propList.insert("style:text-underline-style", "solid");
-      }
-      else if (decoration == "line-through")
-      {
+        break;
+      case VALUE_LINE_THROUGH:
         propList.insert("style:text-line-through-type", "single");
         propList.insert("style:text-line-through-style", "solid");
-      }
-      else if (decoration == "overline")
-      {
+        break;
+      case VALUE_OVERLINE:
         propList.insert("style:text-overline-type", "single");
         propList.insert("style:text-overline-style", "solid");
+        break;
+      default:
+        break;
       }
     }
     sValue = getColor(_findCharacterProperty("color"));
@@ -1322,10 +1512,17 @@ void libabw::ABWContentCollector::_openSpan()
       propList.insert("fo:background-color", sValue.c_str());
 
     sValue = _findCharacterProperty("text-position");
-    if (sValue == "subscript")
+    switch (ABWValueMap::getValueId(sValue))
+    {
+    case VALUE_SUBSCRIPT:
       propList.insert("style:text-position", "sub");
-    else if (sValue == "superscript")
+      break;
+    case VALUE_SUPERSCRIPT:
       propList.insert("style:text-position", "super");
+      break;
+    default:
+      break;
+    }
 
     sValue = _findCharacterProperty("lang");
     if (sValue.empty()) // try document default
@@ -1333,18 +1530,26 @@ void libabw::ABWContentCollector::_openSpan()
 
     if (!sValue.empty())
     {
-      optional<std::string> lang;
-      optional<std::string> country;
-      optional<std::string> script;
-
-      parseLang(sValue, lang, country, script);
-
-      if (bool(lang))
-        propList.insert("fo:language", get(lang).c_str());
-      if (bool(country))
-        propList.insert("fo:country", get(country).c_str());
-      if (bool(script))
-        propList.insert("fo:script", get(script).c_str());
+      auto it = m_languages.find(sValue);
+      if (it == m_languages.end())
+      {
+        optional<std::string> lang;
+        optional<std::string> country;
+        optional<std::string> script;
+
+        parseLang(sValue, lang, country, script);
+
+        it = m_languages.insert(std::make_pair(sValue, std::make_tuple(librevenge::RVNGString(bool(lang) ? get(lang).c_str() : ""),
+                                                                        librevenge::RVNGString(bool(country) ? get(country).c_str() : ""),
+                                                                        librevenge::RVNGString(bool(script) ? get(script).c_str() : "")))).first;
+      }
+
+      if (!std::get<0>(it->second).empty())
+        propList.insert("fo:language", std::get<0>(it->second));
+      if (!std::get<1>(it->second).empty())
+        propList.insert("fo:country", std::get<1>(it->second));
+      if (!std::get<2>(it->second).empty())
+        propList.insert("fo:script", std::get<2>(it->second));
     }
 
     // do we need to check "font-stretch" here or it is always equal to normal ?
@@ -1538,6 +1743,24 @@ void libabw::ABWContentCollector::_closeTableRow()
   m_ps->m_tableStates.top().m_isTableRowOpened = false;
 }
 
+void libabw::ABWContentCollector::_insertEmptyTableRows(int count)
+{
+  if (count <= 0)
+    return;
+  if (m_ps->m_tableStates.top().m_isTableRowOpened)
+    _closeTableRow();
+
+  // a single row element stands for the whole run of empty rows
+  librevenge::RVNGPropertyList propList;
+  if (count > 1)
+    propList.insert("table:number-rows-repeated", count);
+  m_outputElements.addOpenTableRow(propList);
+  m_outputElements.addInsertCoveredTableCell(librevenge::RVNGPropertyList());
+  m_outputElements.addCloseTableRow();
+
+  m_ps->m_tableStates.top().m_currentTableRow += count;
+}
+
 void libabw::ABWContentCollector::_openTableCell()
 {
   librevenge::RVNGPropertyList propList;
@@ -1592,8 +1815,7 @@ void libabw::ABWContentCollector::openFoot(const char *id)
     propList.insert("librevenge:number", id);
   m_outputElements.addOpenFootnote(propList);
 
-  m_parsingStates.push(m_ps);
-  m_ps = std::make_shared<ABWContentParsingState>();
+  _pushParsingState();
 
   m_ps->m_isNote = true;
 }
@@ -1606,11 +1828,7 @@ void libabw::ABWContentCollector::closeFoot()
 
   m_outputElements.addCloseFootnote();
 
-  if (!m_parsingStates.empty())
-  {
-    m_ps = m_parsingStates.top();
-    m_parsingStates.pop();
-  }
+  _popParsingState();
 }
 
 void libabw::ABWContentCollector::openEndnote(const char *id)
@@ -1624,8 +1842,7 @@ void libabw::ABWContentCollector::openEndnote(const char *id)
     propList.insert("librevenge:number", id);
   m_outputElements.addOpenEndnote(propList);
 
-  m_parsingStates.push(m_ps);
-  m_ps = std::make_shared<ABWContentParsingState>();
+  _pushParsingState();
 
   m_ps->m_isNote = true;
 }
@@ -1638,13 +1855,60 @@ void libabw::ABWContentCollector::closeEndnote()
 
   m_outputElements.addCloseEndnote();
 
-  if (!m_parsingStates.empty())
+  _popParsingState();
+}
+
+void libabw::ABWContentCollector::_pushParsingState()
+{
+  m_parsingStates.push(std::move(m_ps));
+  if (m_parsingStatePool.empty())
+    m_ps.reset(new ABWContentParsingState());
+  else
   {
-    m_ps = m_parsingStates.top();
-    m_parsingStates.pop();
+    m_ps = std::move(m_parsingStatePool.back());
+    m_parsingStatePool.pop_back();
+    m_ps->clear();
   }
 }
 
+void libabw::ABWContentCollector::_popParsingState()
+{
+  if (m_parsingStates.empty())
+    return;
+  m_parsingStatePool.push_back(std::move(m_ps));
+  m_ps = std::move(m_parsingStates.top());
+  m_parsingStates.pop();
+}
+
+void libabw::ABWContentCollector::_pushFrameContext()
+{
+  std::unique_ptr<ABWOutputElements> outputElements;
+  if (m_frameOutputPool.empty())
+    outputElements.reset(new ABWOutputElements(m_control));
+  else
+  {
+    outputElements = std::move(m_frameOutputPool.back());
+    m_frameOutputPool.pop_back();
+    outputElements->clear();
+  }
+  // the frame content goes to the fresh buffer, the enclosing content is kept aside
+  m_outputElements.swap(*outputElements);
+  m_frameContexts.emplace(m_parsingStates.size(), std::move(outputElements));
+  _pushParsingState();
+}
+
+libabw::ABWOutputElements *libabw::ABWContentCollector::_popFrameContext()
+{
+  ABWContentFrameContext &context = m_frameContexts.top();
+  while (m_parsingStates.size() > context.m_parsingStateDepth)
+    _popParsingState();
+  m_outputElements.swap(*context.m_outputElements);
+  // the buffer stays valid until the next frame is opened
+  m_frameOutputPool.push_back(std::move(context.m_outputElements));
+  m_frameContexts.pop();
+  return m_frameOutputPool.back().get();
+}
+
 void libabw::ABWContentCollector::openField(const char *type, const char * /*id*/)
 {
   if (!type || type[0]==0)
@@ -1654,210 +1918,163 @@ void libabw::ABWContentCollector::openField(const char *type, const char * /*id*
   }
   if (!m_ps->m_inParagraphOrListElement)
     return;
-  librevenge::RVNGPropertyList propList;
-  std::string typ(type);
-  size_t len=typ.length();
-  // see fp_Fields.h
-  switch (typ[0])
+  // the properties only depend on the type, so compute them once per type
+  auto it = m_fieldProperties.find(type);
+  if (it == m_fieldProperties.end())
   {
-  case 'a':
-    if (len>4 && typ.substr(0,4)=="app_")
+    librevenge::RVNGPropertyList propList;
+    const bool isInserted = _fillFieldProperties(type, propList);
+    if (isInserted && propList.empty())
     {
-      // app_ver, app_compiledate, app_compiletime, app_id, app_target, app_options
-      return;
+      ABW_DEBUG_MSG(("libabw::ABWContentCollector::openField: sorry, unknown type=%s\n", type));
     }
+    it = m_fieldProperties.insert(std::make_pair(std::string(type), std::make_pair(isInserted && !propList.empty(), propList))).first;
+  }
+  if (it->second.first)
+  {
+    if (!m_ps->m_isSpanOpened)
+      _openSpan();
+    m_outputElements.addInsertField(it->second.second);
+    m_ps->m_isFirstTextInListElement = false;
+  }
+}
+
+bool libabw::ABWContentCollector::_fillFieldProperties(const std::string &typ, librevenge::RVNGPropertyList &propList)
+{
+  const char *dtFormat = nullptr;
+  // see fp_Fields.h
+  switch (ABWValueMap::getValueId(typ))
+  {
+  case VALUE_CHAR_COUNT:
+    propList.insert("librevenge:field-type", "text:character-count");
     break;
-  case 'c':
-    if (len==10 && typ=="char_count")
-      propList.insert("librevenge:field-type", "text:character-count");
+  case VALUE_DATE:
+    dtFormat = "%A, %B %d,%Y";
     break;
-  case 'd':
-    if (len==4 && typ=="date")
-    {
-      propList.insert("librevenge:field-type", "text:date");
-      propList.insert("number:automatic-order", "true");
-      librevenge::RVNGPropertyListVector pVect;
-      _convertFieldDTFormat("%A, %B %d,%Y",pVect);
-      propList.insert("librevenge:value-type", "date");
-      propList.insert("librevenge:format", pVect);
-      break;
-    }
-    if (len>5 && typ.substr(0,5)=="date_")
-    {
-      propList.insert("librevenge:field-type", "text:date");
-      propList.insert("number:automatic-order", "true");
-      librevenge::RVNGPropertyListVector pVect;
-      if (len==10 && typ=="date_ntdlf") // default
-        ;
-      else if (len==11 && typ=="date_mmddyy")
-        _convertFieldDTFormat("%m/%d/%y",pVect);
-      else if (len==11 && typ=="date_ddmmyy")
-        _convertFieldDTFormat("%d/%m/%y",pVect);
-      else if (len==8 && typ=="date_mdy")
-        _convertFieldDTFormat("%B %d,%Y",pVect);
-      else if (len==10 && typ=="date_mthdy")
-        _convertFieldDTFormat("%b %d,%Y",pVect);
-      else if (len==8 && typ=="date_dfl")
-        _convertFieldDTFormat("%a %b %d %H:%M:%S %Y",pVect);
-      else if (len==10 && typ=="date_wkday")
-        _convertFieldDTFormat("%A",pVect);
-      else if (len==8 && typ=="date_doy") // normally this is the day of the year
-        _convertFieldDTFormat("%d",pVect);
-      if (!pVect.empty())
-      {
-        propList.insert("librevenge:value-type", "date");
-        propList.insert("librevenge:format", pVect);
-      }
-      break;
-    }
-    if (len==15 && typ=="datetime_custom")   // TODO add format
-    {
-      propList.insert("librevenge:field-type", "text:date");
-      propList.insert("number:automatic-order", "true");
-      librevenge::RVNGPropertyListVector pVect;
-      _convertFieldDTFormat("%d/%m/%y %H:%M:%S",pVect);
-      propList.insert("librevenge:value-type", "date");
-      propList.insert("librevenge:format", pVect);
-      break;
-    }
+  case VALUE_DATE_NTDLF: // default
     break;
-  case 'e':
-    if (len==12 && typ=="endnote_anch")
-      return;
-    if (len==11 && typ=="endnote_ref")
-      return;
+  case VALUE_DATE_MMDDYY:
+    dtFormat = "%m/%d/%y";
     break;
-  case 'f':
-    if (len==9 && typ=="file_name")
-    {
-      propList.insert("librevenge:field-type", "text:file-name");
-      propList.insert("text:display", "full");
-      break;
-    }
-    if (len==13 && typ=="footnote_anch")
-      return;
-    if (len==12 && typ=="footnote_ref")
-      return;
+  case VALUE_DATE_DDMMYY:
+    dtFormat = "%d/%m/%y";
     break;
-  case 'l':
-    if (len==10 && typ=="list_label")
-      return;
-    // line_count
+  case VALUE_DATE_MDY:
+    dtFormat = "%B %d,%Y";
     break;
-  case 'm':
-    if (len>5 && typ.substr(0,5)=="meta_")
-    {
-      if (len==10 && typ=="meta_title")
-        propList.insert("librevenge:field-type", "text:title");
-      else if (len==12 && typ=="meta_subject")
-        propList.insert("librevenge:field-type", "text:subject");
-      else if (len==12 && typ=="meta_creator")
-        propList.insert("librevenge:field-type", "text:creator");
-      else if (len==14 && typ=="meta_publisher")
-        propList.insert("librevenge:field-type", "text:printed-by");
-      //else if (len==16 && typ=="meta_contributor")
-      // else if (len==9 && typ=="meta_type")
-      else if (len==13 && typ=="meta_keywords")
-        propList.insert("librevenge:field-type", "text:keywords");
-      //else if (len==13 && typ=="meta_language")
-      else if (len==16 && typ=="meta_description")
-        propList.insert("librevenge:field-type", "text:description");
-      //else if (len==13 && typ=="meta_coverage")
-      //else if (len==11 && typ=="meta_rights")
-      else if (len==9 && typ=="meta_date")
-        propList.insert("librevenge:field-type", "text:creation-date");
-      else if (len==22 && typ=="meta_date_last_changed")
-        propList.insert("librevenge:field-type", "text:modification-date");
-      break;
-    }
-    if (len==10 && typ=="mail_merge") // a datafield?
-      return;
+  case VALUE_DATE_MTHDY:
+    dtFormat = "%b %d,%Y";
     break;
-  case 'n':
-    // nbsp_count
+  case VALUE_DATE_DFL:
+    dtFormat = "%a %b %d %H:%M:%S %Y";
     break;
-  case 'p':
-    if (len>5 && typ.substr(0,5)=="page_")
-    {
-      if (len==11 && typ=="page_number")
-        propList.insert("librevenge:field-type", "text:page-number");
-      else if (len==10 && typ=="page_count")
-        propList.insert("librevenge:field-type", "text:page-count");
-      // page_ref ?
-      break;
-    }
-    if (len>5 && typ.substr(0,5)=="para_")
-    {
-      if (len==10 && typ=="para_count")
-        propList.insert("librevenge:field-type", "text:paragraph-count");
-      break;
-    }
+  case VALUE_DATE_WKDAY:
+    dtFormat = "%A";
     break;
-  case 's':
-    if (len==15 && typ=="short_file_name")
-    {
-      propList.insert("librevenge:field-type", "text:file-name");
-      propList.insert("text:display", "full"); // checkme
-      break;
-    }
-    if (len>4 && typ.substr(0,4)=="sum_")
-    {
-      // sum_cols, sum_rows
-      break;
-    }
+  case VALUE_DATE_DOY: // normally this is the day of the year
+    dtFormat = "%d";
     break;
-  case 't':
-    if (len==4 && typ=="time")
-    {
-      propList.insert("librevenge:field-type", "text:time");
-      propList.insert("number:automatic-order", "true");
-      break;
-    }
-    if (len>5 && typ.substr(0,5)=="time_")   // TODO add format
-    {
-      propList.insert("librevenge:field-type", "text:time");
-      propList.insert("number:automatic-order", "true");
-      librevenge::RVNGPropertyListVector pVect;
-      if (len==9 && typ=="time_ampm")
-        _convertFieldDTFormat("%I:%M:%S %p",pVect);
-      if (len==9 && typ=="time_zone") // CEST, ...
-        return;
-      // if (len==10 && typ=="time_epoch") //second since ...
-      if (len==12 && typ=="time_miltime") // ""
-        return;
-      if (!pVect.empty())
-      {
-        propList.insert("librevenge:value-type", "time");
-        propList.insert("librevenge:format", pVect);
-      }
-      break;
-    }
-    if (len>4 && typ.substr(0,4)=="toc_")
-    {
-      if (len==14 && typ=="toc_list_label")
-        return;
-      // toc_page_number
-      break;
-    }
+  case VALUE_DATETIME_CUSTOM: // TODO add format
+    dtFormat = "%d/%m/%y %H:%M:%S";
+    break;
+  case VALUE_ENDNOTE_ANCH:
+  case VALUE_ENDNOTE_REF:
+    return false;
+  case VALUE_FILE_NAME:
+  case VALUE_SHORT_FILE_NAME:
+    propList.insert("librevenge:field-type", "text:file-name");
+    propList.insert("text:display", "full"); // checkme for short_file_name
+    break;
+  case VALUE_FOOTNOTE_ANCH:
+  case VALUE_FOOTNOTE_REF:
+    return false;
+  case VALUE_LIST_LABEL:
+    return false;
+  // line_count
+  case VALUE_META_TITLE:
+    propList.insert("librevenge:field-type", "text:title");
+    break;
+  case VALUE_META_SUBJECT:
+    propList.insert("librevenge:field-type", "text:subject");
+    break;
+  case VALUE_META_CREATOR:
+    propList.insert("librevenge:field-type", "text:creator");
+    break;
+  case VALUE_META_PUBLISHER:
+    propList.insert("librevenge:field-type", "text:printed-by");
     break;
-  case 'w':
-    if (len==11 && typ=="word_count")
-      propList.insert("librevenge:field-type", "text:word-count");
+  // meta_contributor, meta_type
+  case VALUE_META_KEYWORDS:
+    propList.insert("librevenge:field-type", "text:keywords");
+    break;
+  // meta_language
+  case VALUE_META_DESCRIPTION:
+    propList.insert("librevenge:field-type", "text:description");
+    break;
+  // meta_coverage, meta_rights
+  case VALUE_META_DATE:
+    propList.insert("librevenge:field-type", "text:creation-date");
+    break;
+  case VALUE_META_DATE_LAST_CHANGED:
+    propList.insert("librevenge:field-type", "text:modification-date");
+    break;
+  case VALUE_MAIL_MERGE: // a datafield?
+    return false;
+  // nbsp_count
+  case VALUE_PAGE_NUMBER:
+    propList.insert("librevenge:field-type", "text:page-number");
+    break;
+  case VALUE_PAGE_COUNT:
+    propList.insert("librevenge:field-type", "text:page-count");
+    break;
+  // page_ref ?
+  case VALUE_PARA_COUNT:
+    propList.insert("librevenge:field-type", "text:paragraph-count");
+    break;
+  // sum_cols, sum_rows
+  case VALUE_TIME:
+    propList.insert("librevenge:field-type", "text:time");
+    propList.insert("number:automatic-order", "true");
+    break;
+  case VALUE_TIME_AMPM: // TODO add format to the other times
+    dtFormat = "%I:%M:%S %p";
+    break;
+  case VALUE_TIME_ZONE: // CEST, ...
+  case VALUE_TIME_MILTIME:
+    return false;
+  // time_epoch: second since ...
+  case VALUE_TOC_LIST_LABEL:
+    return false;
+  // toc_page_number
+  case VALUE_WORD_COUNT:
+    propList.insert("librevenge:field-type", "text:word-count");
     break;
   default:
+    if (typ.compare(0, 4, "app_") == 0 && typ.length() > 4)
+    {
+      // app_ver, app_compiledate, app_compiletime, app_id, app_target, app_options
+      return false;
+    }
     break;
   }
-  if (propList.empty())
-  {
-    ABW_DEBUG_MSG(("libabw::ABWContentCollector::openField: sorry, unknown type=%s\n", type));
-  }
-  else
+
+  // the other date and time fields have no format
+  const bool isTime = typ.compare(0, 5, "time_") == 0 && typ.length() > 5;
+  const bool isDate = !isTime && (dtFormat || (typ.compare(0, 5, "date_") == 0 && typ.length() > 5));
+  if (isDate || isTime)
   {
-    if (!m_ps->m_isSpanOpened)
-      _openSpan();
-    m_outputElements.addInsertField(propList);
-    m_ps->m_isFirstTextInListElement = false;
+    propList.insert("librevenge:field-type", isTime ? "text:time" : "text:date");
+    propList.insert("number:automatic-order", "true");
+    librevenge::RVNGPropertyListVector pVect;
+    if (dtFormat)
+      _convertFieldDTFormat(dtFormat, pVect);
+    if (!pVect.empty())
+    {
+      propList.insert("librevenge:value-type", isTime ? "time" : "date");
+      propList.insert("librevenge:format", pVect);
+    }
   }
+  return true;
 }
 
 bool libabw::ABWContentCollector::_convertFieldDTFormat(std::string const &dtFormat, librevenge::RVNGPropertyListVector &propVect)
@@ -1997,7 +2214,7 @@ void libabw::ABWContentCollector::openTable(const char *props)
     }
   }
 
-  m_ps->m_tableStates.push(ABWContentTableState());
+  m_ps->m_tableStates.emplace();
   m_ps->m_tableStates.top().m_currentTableId = m_tableCounter++;
   if (props)
     parsePropString(props, m_ps->m_tableStates.top().m_currentTableProperties);
@@ -2023,10 +2240,11 @@ void libabw::ABWContentCollector::openCell(const char *props)
     if (currentRow > MAX_TABLE_ROW)
       currentRow = MAX_TABLE_ROW;
 
-    while (m_ps->m_tableStates.top().m_currentTableRow < currentRow)
+    if (m_ps->m_tableStates.top().m_currentTableRow < currentRow)
     {
       if (m_ps->m_tableStates.top().m_currentTableRow >= 0)
         _closeTableRow();
+      _insertEmptyTableRows(currentRow - m_ps->m_tableStates.top().m_currentTableRow - 1);
       _openTableRow();
     }
 
@@ -2080,6 +2298,7 @@ void libabw::ABWContentCollector::closeCell()
 
 void libabw::ABWContentCollector::openFrame(const char *props, const char *imageId, const char */*title*/, const char */*alt*/)
 {
+  _pushFrameContext();
   ABWPropertyMap propMap;
   if (props)
     parsePropString(props, propMap);
@@ -2100,15 +2319,21 @@ void libabw::ABWContentCollector::openFrame(const char *props, const char *image
   iter = propMap.find("position-to");
   if (iter != propMap.end())
   {
-    if (iter->second=="page-above-text")
+    switch (ABWValueMap::getValueId(iter->second))
+    {
+    case VALUE_PAGE_ABOVE_TEXT:
       isParagraph=false;
-    else if (iter->second=="column-above-text")
+      break;
+    case VALUE_COLUMN_ABOVE_TEXT:
       /* unsure how to retrieve that, so check if the page positions
          are defined, if yes, use a page anchor. */
       isParagraph=(propMap.find("frame-page-ypos")==propMap.end());
-    else if (iter->second!="block-above-text")
-    {
+      break;
+    case VALUE_BLOCK_ABOVE_TEXT:
+      break;
+    default:
       ABW_DEBUG_MSG(("libabw::ABWContentCollector::openFrame: sorry, unknown pos: %s asume paragraph\n", iter->second.c_str()));
+      break;
     }
   }
   iter = propMap.find(isParagraph ? "xpos" : "frame-page-xpos");
@@ -2146,25 +2371,28 @@ void libabw::ABWContentCollector::openFrame(const char *props, const char *image
   iter = propMap.find("wrap-mode");
   if (iter != propMap.end())
   {
-    if (iter->second=="wrapped-to-left")
+    switch (ABWValueMap::getValueId(iter->second))
+    {
+    case VALUE_WRAPPED_TO_LEFT:
       propList.insert("style:wrap", "left");
-    else if (iter->second=="wrapped-to-right")
+      break;
+    case VALUE_WRAPPED_TO_RIGHT:
       propList.insert("style:wrap", "right");
-    else if (iter->second=="wrapped-to-both")
+      break;
+    case VALUE_WRAPPED_TO_BOTH:
       propList.insert("style:wrap", "parallel");
-    else if (iter->second=="above-text")
-    {
+      break;
+    case VALUE_ABOVE_TEXT:
       propList.insert("style:wrap", "dynamic");
       propList.insert("style:run-through", "foreground");
-    }
-    else if (iter->second=="below-text")
-    {
+      break;
+    case VALUE_BELOW_TEXT:
       propList.insert("style:wrap", "dynamic");
       propList.insert("style:run-through", "background");
-    }
-    else
-    {
+      break;
+    default:
       ABW_DEBUG_MSG(("libabw::ABWContentCollector::openFrame: sorry, unknown wrap mode: %s\n", iter->second.c_str()));
+      break;
     }
   }
   m_ps->m_isPageFrame=!isParagraph;
@@ -2211,25 +2439,34 @@ void libabw::ABWContentCollector::closeFrame(libabw::ABWOutputElements *(&elemen
 {
   elements=nullptr;
   pageFrame=false;
+  if (m_frameContexts.empty())
+  {
+    ABW_DEBUG_MSG(("libabw::ABWContentCollector::closeFrame: oops, no frame is opened\n"));
+    return;
+  }
+  bool isFrame=false;
   if (m_ps->m_isNote)
   {
     ABW_DEBUG_MSG(("libabw::ABWContentCollector::closeFrame: sorry, oops, sorry, a note is not closed\n"));
-    return;
   }
-  if (m_ps->m_parsingContext!=ABW_FRAME_IMAGE && m_ps->m_parsingContext!=ABW_FRAME_TEXTBOX)
-    return;
+  else if (m_ps->m_parsingContext==ABW_FRAME_IMAGE || m_ps->m_parsingContext==ABW_FRAME_TEXTBOX)
+  {
+    while (!m_ps->m_tableStates.empty())
+      _closeTable();
+    _closeBlock();
+    m_ps->m_currentListLevel = 0;
+    _changeList(); // flush the list
 
-  while (!m_ps->m_tableStates.empty())
-    _closeTable();
-  _closeBlock();
-  m_ps->m_currentListLevel = 0;
-  _changeList(); // flush the list
+    if (m_ps->m_parsingContext==ABW_FRAME_TEXTBOX)
+      m_outputElements.addCloseTextBox();
+    m_outputElements.addCloseFrame();
+    pageFrame=m_ps->m_isPageFrame;
+    isFrame=true;
+  }
 
-  if (m_ps->m_parsingContext==ABW_FRAME_TEXTBOX)
-    m_outputElements.addCloseTextBox();
-  m_outputElements.addCloseFrame();
-  elements=&m_outputElements;
-  pageFrame=m_ps->m_isPageFrame;
+  ABWOutputElements *frameElements=_popFrameContext();
+  if (isFrame)
+    elements=frameElements;
 }
 
 void libabw::ABWContentCollector::addFrameElements(ABWOutputElements &elements, bool pageFrame)
@@ -2247,6 +2484,12 @@ void libabw::ABWContentCollector::collectData(const char *, const char *, const
 {
 }
 
+bool libabw::ABWContentCollector::isElementIgnored(const int tokenId) const
+{
+  // the lists and the data were collected in the styles pass
+  return tokenId == XML_LISTS || tokenId == XML_DATA;
+}
+
 void libabw::ABWContentCollector::insertImage(const char *dataid, const char *props)
 {
   if (!m_ps->m_isSpanOpened)
@@ -2299,7 +2542,7 @@ void libabw::ABWContentCollector::_handleListChange()
   {
     if (!m_ps->m_isSectionOpened)
       _openSection();
-    _recurseListLevels(oldListLevel, m_ps->m_currentListLevel, m_ps->m_currentListId);
+    _recurseListLevels(oldListLevel, m_ps->m_currentListLevel, m_listTable.find(m_ps->m_currentListId));
   }
   else if (m_ps->m_currentListLevel < oldListLevel)
   {
@@ -2320,37 +2563,24 @@ void libabw::ABWContentCollector::_writeOutDummyListLevels(int oldLevel, int new
   if (oldLevel < newLevel)
   {
     _writeOutDummyListLevels(oldLevel, newLevel-1);
-    m_dummyListElements.push_back(std::make_shared<ABWUnorderedListElement>());
-    m_dummyListElements.back()->m_listLevel = newLevel;
-    m_ps->m_listLevels.push(std::make_pair(newLevel, m_dummyListElements.back()));
-    librevenge::RVNGPropertyList propList;
-    m_dummyListElements.back()->writeOut(propList);
-    m_outputElements.addOpenUnorderedListLevel(propList);
+    m_ps->m_listLevels.push(std::make_pair(newLevel, m_listTable.getDummyElement()));
+    m_outputElements.addOpenUnorderedListLevel(m_listTable.getDummyPropList(newLevel));
   }
 }
 
-void libabw::ABWContentCollector::_recurseListLevels(int oldLevel, int newLevel, int newListId)
+void libabw::ABWContentCollector::_recurseListLevels(int oldLevel, int newLevel, const ABWListTable::Entry *list)
 {
-  if (oldLevel >= newLevel)
+  if (oldLevel >= newLevel || !list)
     return;
-  const auto iter = m_listElements.find(newListId);
-  if (iter != m_listElements.end() && iter->second)
-  {
-    if (iter->second->m_parentId)
-      _recurseListLevels(oldLevel, newLevel-1, iter->second->m_parentId);
-    else
-      _writeOutDummyListLevels(oldLevel, newLevel-1);
-    m_ps->m_listLevels.push(std::make_pair(newLevel, iter->second));
-    librevenge::RVNGPropertyList propList;
-    iter->second->writeOut(propList);
-    // osnola: use the element list id if set, if not use newListId
-    propList.insert("librevenge:list-id",
-                    iter->second->m_listId ? iter->second->m_listId : newListId);
-    if (iter->second->getType() == ABW_UNORDERED)
-      m_outputElements.addOpenUnorderedListLevel(propList);
-    else
-      m_outputElements.addOpenOrderedListLevel(propList);
-  }
+  if (list->m_element->m_parentId)
+    _recurseListLevels(oldLevel, newLevel-1, list->m_parent);
+  else
+    _writeOutDummyListLevels(oldLevel, newLevel-1);
+  m_ps->m_listLevels.push(std::make_pair(newLevel, list->m_element));
+  if (list->m_element->getType() == ABW_UNORDERED)
+    m_outputElements.addOpenUnorderedListLevel(list->m_propList);
+  else
+    m_outputElements.addOpenOrderedListLevel(list->m_propList);
 }
 
 void libabw::ABWContentCollector::_changeList()
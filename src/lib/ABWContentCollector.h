@@ -14,6 +14,7 @@
 #include <vector>
 #include <stack>
 #include <set>
+#include <tuple>
 
 #include <librevenge/librevenge.h>
 #include "ABWOutputElements.h"
@@ -22,6 +23,9 @@
 namespace libabw
 {
 
+struct AbiParseStatistics;
+class ABWParseControl;
+
 enum ABWContext
 {
   ABW_SECTION,
@@ -44,9 +48,13 @@ struct ABWStyle
 struct ABWContentTableState
 {
   ABWContentTableState();
-  ABWContentTableState(const ABWContentTableState &ts);
+  ABWContentTableState(ABWContentTableState &&ts) = default;
+  ABWContentTableState &operator=(ABWContentTableState &&ts) = default;
   ~ABWContentTableState();
 
+  ABWContentTableState(const ABWContentTableState &) = delete;
+  ABWContentTableState &operator=(const ABWContentTableState &) = delete;
+
   ABWPropertyMap m_currentTableProperties;
   ABWPropertyMap m_currentCellProperties;
 
@@ -64,9 +72,18 @@ struct ABWContentTableState
 struct ABWContentParsingState
 {
   ABWContentParsingState();
-  ABWContentParsingState(const ABWContentParsingState &ps);
   ~ABWContentParsingState();
 
+  ABWContentParsingState(const ABWContentParsingState &) = delete;
+  ABWContentParsingState &operator=(const ABWContentParsingState &) = delete;
+
+  //! reset to the initial state, keeping the allocated memory where possible
+  void clear();
+  //! copy state, which must not be in a table
+  void assign(const ABWContentParsingState &state);
+  //! whether the content that follows would be collected the same as in state, which may not have started the document yet; neither may be in a table
+  bool isSame(const ABWContentParsingState &state) const;
+
   bool m_isDocumentStarted;
   bool m_isPageSpanOpened;
   bool m_isSectionOpened;
@@ -111,16 +128,50 @@ struct ABWContentParsingState
   int m_currentListId;
   bool m_isFirstTextInListElement;
 
-  std::stack<ABWContentTableState> m_tableStates;
+  std::stack<ABWContentTableState, std::vector<ABWContentTableState>> m_tableStates;
   std::stack<std::pair<int, std::shared_ptr<ABWListElement>>> m_listLevels;
 };
 
+//! what must be restored when a frame is closed
+struct ABWContentFrameContext
+{
+  ABWContentFrameContext(std::size_t parsingStateDepth, std::unique_ptr<ABWOutputElements> &&outputElements)
+    : m_parsingStateDepth(parsingStateDepth)
+    , m_outputElements(std::move(outputElements))
+  {
+  }
+
+  //! the size of the parsing state stack before the frame was opened
+  std::size_t m_parsingStateDepth;
+  //! the output elements of the enclosing context
+  std::unique_ptr<ABWOutputElements> m_outputElements;
+};
+
+/** The state of the content collector between two top-level sections,
+    which the next section continues from.
+  */
+struct ABWContentSectionState
+{
+  ABWContentSectionState();
+  ~ABWContentSectionState();
+
+  ABWContentSectionState(const ABWContentSectionState &) = delete;
+  ABWContentSectionState &operator=(const ABWContentSectionState &) = delete;
+
+  ABWContentParsingState m_ps;
+  int m_tableCounter;
+  std::map<std::string, ABWStyle> m_textStyles;
+  ABWPropertyMap m_documentStyle;
+  ABWPropertyMap m_metadata;
+};
+
 class ABWContentCollector : public ABWCollector
 {
 public:
   ABWContentCollector(librevenge::RVNGTextInterface *iface, const std::map<int, int> &tableSizes,
                       const std::map<std::string, ABWData> &data,
-                      const std::map<int, std::shared_ptr<ABWListElement>> &listElements);
+                      const ABWListTable &listTable,
+                      AbiParseStatistics *statistics = nullptr, ABWParseControl *control = nullptr);
   ~ABWContentCollector() override;
 
   // collector functions
@@ -167,6 +218,25 @@ public:
 
   void addMetadataEntry(const char *name, const char *value) override;
 
+  bool isElementIgnored(int tokenId) const override;
+
+  //! convert the AbiWord metadata entries to librevenge document metadata
+  static void convertMetadata(const ABWPropertyMap &metadata, librevenge::RVNGPropertyList &propList);
+
+  // parsing of the content in parts, by several collectors; see ABWParser
+
+  //! whether the collector is between two top-level sections, with nothing but the page span open
+  bool isBetweenSections() const;
+  void saveSectionState(ABWContentSectionState &state) const;
+  //! whether collector, which started in state, collected what this collector would
+  bool canAppendSections(const ABWContentSectionState &state, const ABWContentCollector &collector) const;
+  //! append the output of collector, which collected the sections that follow, and continue in its state
+  void appendSections(ABWContentCollector &collector);
+  //! count tables that were not collected, so the next table gets the right size
+  void skipTables(int count);
+  //! drop the output collected so far
+  void clearOutput();
+
 private:
   ABWContentCollector(const ABWContentCollector &);
   ABWContentCollector &operator=(const ABWContentCollector &);
@@ -194,7 +264,12 @@ private:
 
   void _handleListChange();
   void _changeList();
-  void _recurseListLevels(int oldLevel, int newLevel, int listId);
+  void _pushParsingState();
+  void _popParsingState();
+  void _pushFrameContext();
+  //! restore the context of the enclosing frame; returns the elements of the closed frame
+  ABWOutputElements *_popFrameContext();
+  void _recurseListLevels(int oldLevel, int newLevel, const ABWListTable::Entry *list);
   void _writeOutDummyListLevels(int oldLevel, int newLevel);
 
   void _openSpan();
@@ -204,6 +279,7 @@ private:
   void _closeTable();
   void _openTableRow();
   void _closeTableRow();
+  void _insertEmptyTableRows(int count);
   void _openTableCell();
   void _closeTableCell();
 
@@ -219,16 +295,21 @@ private:
   std::string _findTableProperty(const char *name);
   std::string _findCellProperty(const char *name);
   std::string _findSectionProperty(const char *name);
-  std::string _findMetadataEntry(const char *name);
 
   void _fillParagraphProperties(librevenge::RVNGPropertyList &propList, bool isListElement);
+  //! fill the properties of a field of type typ; returns false if the field must be ignored
+  bool _fillFieldProperties(const std::string &typ, librevenge::RVNGPropertyList &propList);
   bool _convertFieldDTFormat(std::string const &dtFormat, librevenge::RVNGPropertyListVector &propVect);
 
   int getCellPos(const char *startProp, const char *endProp, int defStart);
 
-  std::shared_ptr<ABWContentParsingState> m_ps;
+  std::unique_ptr<ABWContentParsingState> m_ps;
   librevenge::RVNGTextInterface *m_iface;
-  std::stack<std::shared_ptr<ABWContentParsingState> > m_parsingStates;
+  AbiParseStatistics *m_statistics;
+  ABWParseControl *m_control;
+  std::stack<std::unique_ptr<ABWContentParsingState> > m_parsingStates;
+  //! parsing states of closed notes, for reuse
+  std::vector<std::unique_ptr<ABWContentParsingState>> m_parsingStatePool;
   std::set<std::string> m_dontLoop;
   std::map<std::string, ABWStyle> m_textStyles;
 
@@ -240,8 +321,18 @@ private:
   int m_tableCounter;
   ABWOutputElements m_outputElements;
   ABWOutputElements m_pageOutputElements;
-  const std::map<int, std::shared_ptr<ABWListElement>> &m_listElements;
-  std::vector<std::shared_ptr<ABWListElement>> m_dummyListElements;
+  const ABWListTable &m_listTable;
+  //! border property values, by (width, style, color)
+  std::map<std::tuple<double, int, std::string>, librevenge::RVNGString> m_borderCache;
+  //! field properties, by field type; the flag is false for ignored fields
+  std::map<std::string, std::pair<bool, librevenge::RVNGPropertyList>> m_fieldProperties;
+  //! language, country and script, by lang value; unknown parts are empty
+  std::map<std::string, std::tuple<librevenge::RVNGString, librevenge::RVNGString, librevenge::RVNGString>> m_languages;
+  //! decoded link targets, by href value
+  std::map<std::string, librevenge::RVNGString> m_decodedUrls;
+  std::stack<ABWContentFrameContext, std::vector<ABWContentFrameContext>> m_frameContexts;
+  //! output buffers of closed frames, for reuse
+  std::vector<std::unique_ptr<ABWOutputElements>> m_frameOutputPool;
 };
 
 } // namespace libabw
@@ -0,0 +1,184 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ABWDataDecoder.h"
+
+#include <chrono>
+#include <system_error>
+
+#include <libabw/AbiParseStatistics.h>
+
+#include "ABWCollector.h"
+#include "ABWParseControl.h"
+#include "libabw_internal.h"
+
+namespace libabw
+{
+
+namespace
+{
+
+//! smaller base64 data are decoded on the parsing thread, where it is cheaper than handing them over
+const unsigned long MIN_DECODED_DATA_SIZE = 16 * 1024;
+
+}
+
+ABWDataDecoder::Job::Job()
+  : m_name()
+  , m_mimeType()
+  , m_base64(false)
+  , m_encoded()
+  , m_data()
+  , m_exception()
+  , m_isDone(false)
+{
+}
+
+ABWDataDecoder::ABWDataDecoder(const unsigned threads)
+  : m_maxThreads(threads)
+  , m_jobs()
+  , m_queue()
+  , m_mutex()
+  , m_condition()
+  , m_stop(false)
+  , m_threads()
+  , m_maxDataSize(0)
+{
+}
+
+ABWDataDecoder::~ABWDataDecoder()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_condition.notify_all();
+  for (auto &thread : m_threads)
+    thread.join();
+}
+
+void ABWDataDecoder::add(const char *const name, const char *const mimeType, const bool base64,
+                         const char *const data, const unsigned long length, ABWParseControl *const control)
+{
+  // 4 characters of base64 decode to at most 3 bytes
+  const unsigned long maxSize = base64 ? length / 4 * 3 : length;
+  if (control)
+    control->checkDataBytes(m_maxDataSize + maxSize);
+  m_maxDataSize += maxSize;
+
+  std::unique_ptr<Job> job(new Job());
+  if (name)
+    job->m_name.reset(new std::string(name));
+  if (mimeType)
+    job->m_mimeType.reset(new std::string(mimeType));
+  job->m_base64 = base64;
+  Job &added = *job;
+
+  if (!base64 || length < MIN_DECODED_DATA_SIZE)
+  {
+    if (base64)
+      added.m_data.appendBase64Data(data);
+    else
+      added.m_data.append(reinterpret_cast<const unsigned char *>(data), length);
+    added.m_isDone = true;
+    m_jobs.push_back(std::move(job));
+    return;
+  }
+
+  // the reader reuses its buffers, so the data are copied
+  added.m_encoded.assign(data, length);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_jobs.push_back(std::move(job));
+  m_queue.push_back(&added);
+  if (m_threads.size() < m_maxThreads && m_threads.size() < m_queue.size())
+  {
+    try
+    {
+      m_threads.push_back(std::thread(&ABWDataDecoder::run, this));
+    }
+    catch (const std::system_error &)
+    {
+      ABW_DEBUG_MSG(("ABWDataDecoder: cannot start a thread\n"));
+    }
+  }
+  if (m_threads.empty())
+  {
+    // nothing would decode it
+    m_queue.pop_back();
+    lock.unlock();
+    decode(added);
+    added.m_isDone = true;
+    return;
+  }
+  lock.unlock();
+  m_condition.notify_one();
+}
+
+void ABWDataDecoder::decode(Job &job)
+{
+  try
+  {
+    job.m_data.appendBase64Data(job.m_encoded.c_str());
+  }
+  catch (...)
+  {
+    job.m_exception = std::current_exception();
+  }
+  std::string().swap(job.m_encoded);
+}
+
+void ABWDataDecoder::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_condition.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+    if (m_stop)
+      return;
+    Job &job = *m_queue.front();
+    m_queue.pop_front();
+    lock.unlock();
+    decode(job);
+    lock.lock();
+    job.m_isDone = true;
+    // finish() waits on the same condition
+    m_condition.notify_all();
+  }
+}
+
+void ABWDataDecoder::finish(ABWCollector &collector, AbiParseStatistics *const statistics, ABWParseControl *const control)
+{
+  for (auto &job : m_jobs)
+  {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      while (!job->m_isDone)
+      {
+        m_condition.wait_for(lock, std::chrono::milliseconds(50));
+        if (control)
+          control->checkCancelled();
+      }
+    }
+    if (job->m_exception)
+      std::rethrow_exception(job->m_exception);
+    if (statistics && job->m_base64)
+      statistics->m_base64DecodedBytes += job->m_data.size();
+    if (control)
+      control->addDataBytes(job->m_data.size());
+    collector.collectData(job->m_name ? job->m_name->c_str() : nullptr, job->m_mimeType ? job->m_mimeType->c_str() : nullptr,
+                          job->m_data);
+    job.reset();
+  }
+  m_jobs.clear();
+  m_maxDataSize = 0;
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,93 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWDATADECODER_H__
+#define __ABWDATADECODER_H__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <librevenge/librevenge.h>
+
+namespace libabw
+{
+
+struct AbiParseStatistics;
+class ABWCollector;
+class ABWParseControl;
+
+/** Decodes the contents of <d> elements on other threads, while the
+    parsing goes on.
+
+    The data are passed to the collector by finish(), in the order in
+    which they were added, so a later <d> replaces an earlier one of the
+    same name, as it does when the data are collected at once.
+  */
+class ABWDataDecoder
+{
+public:
+  explicit ABWDataDecoder(unsigned threads);
+  ~ABWDataDecoder();
+
+  ABWDataDecoder(const ABWDataDecoder &) = delete;
+  ABWDataDecoder &operator=(const ABWDataDecoder &) = delete;
+
+  /** add the contents of a <d> element; name and mimeType may be nullptr
+
+      The data are checked against the limit of control before they are
+      decoded or copied, by the most they can decode to; finish() adds
+      their exact size.
+    */
+  void add(const char *name, const char *mimeType, bool base64, const char *data, unsigned long length,
+           ABWParseControl *control);
+  //! wait for the decoding and collect the data; rethrows what the decoding threw
+  void finish(ABWCollector &collector, AbiParseStatistics *statistics, ABWParseControl *control);
+
+private:
+  struct Job
+  {
+    Job();
+
+    std::unique_ptr<std::string> m_name;
+    std::unique_ptr<std::string> m_mimeType;
+    bool m_base64;
+    //! the base64 data, until they are decoded
+    std::string m_encoded;
+    librevenge::RVNGBinaryData m_data;
+    std::exception_ptr m_exception;
+    bool m_isDone;
+  };
+
+  void run();
+  //! decode the base64 data of job, keeping what it throws
+  static void decode(Job &job);
+
+  const unsigned m_maxThreads;
+  //! all the jobs, in the order they were added
+  std::vector<std::unique_ptr<Job>> m_jobs;
+  //! the jobs waiting for a thread
+  std::deque<Job *> m_queue;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  bool m_stop;
+  std::vector<std::thread> m_threads;
+  //! the most the data added since the last finish() can decode to
+  unsigned long m_maxDataSize;
+};
+
+} // namespace libabw
+
+#endif // __ABWDATADECODER_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
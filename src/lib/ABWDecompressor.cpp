@@ -0,0 +1,492 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <string.h>
+
+#include "ABWDecompressor.h"
+#include "ABWParseControl.h"
+#include "libabw_internal.h"
+#include "ABWInflate.h"
+#include <libabw/AbiMappedFileStream.h>
+
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#ifdef HAVE_LZMA
+#include <lzma.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define BLOCK_SIZE 16384
+
+namespace libabw
+{
+
+namespace
+{
+
+class ABWInflateDecompressor : public ABWDecompressor
+{
+public:
+  bool decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                  std::vector<unsigned char> &buffer, ABWParseControl *control) override;
+  Backend getBackend() const override
+  {
+    return BACKEND_INFLATE;
+  }
+  const char *getName() const override
+  {
+    return ABW_INFLATE_NAME;
+  }
+};
+
+bool ABWInflateDecompressor::decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                                        std::vector<unsigned char> &buffer, ABWParseControl *control)
+{
+  buffer.clear();
+  if (!input || input->seek(0, librevenge::RVNG_SEEK_SET))
+    return false;
+  if (size)
+    buffer.reserve(size);
+
+  int ret;
+  ABWZStream strm;
+  unsigned char in[BLOCK_SIZE];
+
+  strm.zalloc = nullptr;
+  strm.zfree = nullptr;
+  strm.opaque = nullptr;
+  strm.avail_in = 0;
+  strm.next_in = nullptr;
+  ret = abwInflateInit2(&strm, 16 + MAX_WBITS);
+  if (Z_OK != ret)
+    return false;
+
+  try
+  {
+    do
+    {
+      if (control)
+        control->checkCancelled();
+      unsigned long numBytesRead(0);
+      const unsigned char *p = input->read(BLOCK_SIZE, numBytesRead);
+      strm.avail_in = unsigned(numBytesRead);
+      if (!strm.avail_in)
+        break;
+      memcpy(in, p, strm.avail_in);
+      strm.next_in = in;
+
+      do
+      {
+        // inflate directly behind the data inflated so far
+        const size_t pos = buffer.size();
+        buffer.resize(pos + BLOCK_SIZE);
+        strm.avail_out = BLOCK_SIZE;
+        strm.next_out = &buffer[pos];
+        ret = abwInflate(&strm, Z_NO_FLUSH);
+        buffer.resize(pos + BLOCK_SIZE - strm.avail_out);
+        switch (ret)
+        {
+        case Z_NEED_DICT:
+        case Z_DATA_ERROR:
+        case Z_MEM_ERROR:
+        case Z_STREAM_ERROR:
+          (void)abwInflateEnd(&strm);
+          return false;
+        default:
+          break;
+        }
+        if (control)
+          control->checkInflatedSize(buffer.size());
+      }
+      while (!strm.avail_out);
+    }
+    while (Z_STREAM_END != ret);
+  }
+  catch (...)
+  {
+    (void)abwInflateEnd(&strm);
+    throw;
+  }
+
+  (void)abwInflateEnd(&strm);
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  return Z_STREAM_END == ret;
+}
+
+#ifdef HAVE_LIBDEFLATE
+
+class ABWLibdeflateDecompressor : public ABWDecompressor
+{
+public:
+  ABWLibdeflateDecompressor();
+  ~ABWLibdeflateDecompressor() override;
+
+  bool decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                  std::vector<unsigned char> &buffer, ABWParseControl *control) override;
+  Backend getBackend() const override
+  {
+    return BACKEND_LIBDEFLATE;
+  }
+  const char *getName() const override
+  {
+    return "libdeflate";
+  }
+
+private:
+  ABWLibdeflateDecompressor(const ABWLibdeflateDecompressor &);
+  ABWLibdeflateDecompressor &operator=(const ABWLibdeflateDecompressor &);
+
+  libdeflate_decompressor *m_decompressor;
+};
+
+ABWLibdeflateDecompressor::ABWLibdeflateDecompressor()
+  : m_decompressor(libdeflate_alloc_decompressor())
+{
+}
+
+ABWLibdeflateDecompressor::~ABWLibdeflateDecompressor()
+{
+  if (m_decompressor)
+    libdeflate_free_decompressor(m_decompressor);
+}
+
+bool ABWLibdeflateDecompressor::decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                                           std::vector<unsigned char> &buffer, ABWParseControl *control)
+{
+  buffer.clear();
+  if (!m_decompressor || !input || !size || input->seek(0, librevenge::RVNG_SEEK_SET))
+    return false;
+  if (control)
+  {
+    control->checkCancelled();
+    control->checkInflatedSize(size);
+  }
+
+  // the whole compressed document is needed
+  const unsigned char *data = nullptr;
+  unsigned long dataSize = 0;
+  std::vector<unsigned char> compressed;
+  if (const auto *const mapped = dynamic_cast<const AbiMappedFileStream *>(input))
+  {
+    data = mapped->getData();
+    dataSize = mapped->getSize();
+  }
+  if (!data)
+  {
+    while (!input->isEnd())
+    {
+      unsigned long numBytesRead(0);
+      const unsigned char *p = input->read(BLOCK_SIZE, numBytesRead);
+      if (!p || !numBytesRead)
+        break;
+      compressed.insert(compressed.end(), p, p + numBytesRead);
+    }
+    if (compressed.empty())
+      return false;
+    data = &compressed[0];
+    dataSize = compressed.size();
+  }
+
+  buffer.resize(size);
+  size_t inflatedSize = 0;
+  const libdeflate_result ret = libdeflate_gzip_decompress_ex(m_decompressor, data, dataSize, &buffer[0], size,
+                                                              nullptr, &inflatedSize);
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  if (LIBDEFLATE_SUCCESS != ret)
+  {
+    ABW_DEBUG_MSG(("ABWLibdeflateDecompressor::decompress: failed with %d\n", int(ret)));
+    buffer.clear();
+    return false;
+  }
+  buffer.resize(inflatedSize);
+  return true;
+}
+
+#endif
+
+#ifdef HAVE_LZMA
+
+//! the most memory the xz decoder may use; xz -9 needs 65 MiB
+const uint64_t MAX_XZ_DECODER_MEMORY = 256 * 1024 * 1024;
+
+class ABWXzDecompressor : public ABWDecompressor
+{
+public:
+  bool decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                  std::vector<unsigned char> &buffer, ABWParseControl *control) override;
+  Backend getBackend() const override
+  {
+    return BACKEND_XZ;
+  }
+  const char *getName() const override
+  {
+    return "xz";
+  }
+};
+
+bool ABWXzDecompressor::decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                                   std::vector<unsigned char> &buffer, ABWParseControl *control)
+{
+  buffer.clear();
+  if (!input || input->seek(0, librevenge::RVNG_SEEK_SET))
+    return false;
+  if (size)
+    buffer.reserve(size);
+
+  lzma_stream strm = LZMA_STREAM_INIT;
+  if (LZMA_OK != lzma_stream_decoder(&strm, MAX_XZ_DECODER_MEMORY, LZMA_CONCATENATED))
+    return false;
+
+  lzma_ret ret = LZMA_OK;
+  try
+  {
+    lzma_action action = LZMA_RUN;
+    while (LZMA_OK == ret)
+    {
+      if (!strm.avail_in && LZMA_RUN == action)
+      {
+        if (control)
+          control->checkCancelled();
+        unsigned long numBytesRead(0);
+        const unsigned char *p = input->read(BLOCK_SIZE, numBytesRead);
+        strm.next_in = p;
+        strm.avail_in = p ? numBytesRead : 0;
+        if (!strm.avail_in)
+          action = LZMA_FINISH;
+      }
+
+      const size_t pos = buffer.size();
+      buffer.resize(pos + BLOCK_SIZE);
+      strm.next_out = &buffer[pos];
+      strm.avail_out = BLOCK_SIZE;
+      ret = lzma_code(&strm, action);
+      buffer.resize(pos + BLOCK_SIZE - strm.avail_out);
+      if (control)
+        control->checkInflatedSize(buffer.size());
+    }
+    // a stream made with a dictionary larger than the decoder may allocate
+    if (LZMA_MEMLIMIT_ERROR == ret && control)
+      control->decoderMemoryExceeded();
+  }
+  catch (...)
+  {
+    lzma_end(&strm);
+    throw;
+  }
+
+  lzma_end(&strm);
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  return LZMA_STREAM_END == ret;
+}
+
+#endif
+
+#ifdef HAVE_ZSTD
+
+class ABWZstdDecompressor : public ABWDecompressor
+{
+public:
+  ABWZstdDecompressor();
+  ~ABWZstdDecompressor() override;
+
+  bool decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                  std::vector<unsigned char> &buffer, ABWParseControl *control) override;
+  Backend getBackend() const override
+  {
+    return BACKEND_ZSTD;
+  }
+  const char *getName() const override
+  {
+    return "zstd";
+  }
+
+private:
+  ABWZstdDecompressor(const ABWZstdDecompressor &);
+  ABWZstdDecompressor &operator=(const ABWZstdDecompressor &);
+
+  ZSTD_DStream *m_stream;
+};
+
+ABWZstdDecompressor::ABWZstdDecompressor()
+  : m_stream(ZSTD_createDStream())
+{
+}
+
+ABWZstdDecompressor::~ABWZstdDecompressor()
+{
+  if (m_stream)
+    ZSTD_freeDStream(m_stream);
+}
+
+bool ABWZstdDecompressor::decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                                     std::vector<unsigned char> &buffer, ABWParseControl *control)
+{
+  buffer.clear();
+  if (!m_stream || !input || input->seek(0, librevenge::RVNG_SEEK_SET))
+    return false;
+  if (ZSTD_isError(ZSTD_initDStream(m_stream)))
+    return false;
+  if (size)
+    buffer.reserve(size);
+
+  // 0 once a frame has been completely decoded and flushed
+  size_t ret = 1;
+  while (true)
+  {
+    if (control)
+      control->checkCancelled();
+    unsigned long numBytesRead(0);
+    const unsigned char *p = input->read(BLOCK_SIZE, numBytesRead);
+    if (!p || !numBytesRead)
+      break;
+    // zstd does not consume the end of a frame before it has flushed its data
+    ZSTD_inBuffer in = { p, numBytesRead, 0 };
+    while (in.pos < in.size)
+    {
+      const size_t pos = buffer.size();
+      buffer.resize(pos + BLOCK_SIZE);
+      ZSTD_outBuffer out = { &buffer[pos], BLOCK_SIZE, 0 };
+      ret = ZSTD_decompressStream(m_stream, &out, &in);
+      buffer.resize(pos + out.pos);
+      if (ZSTD_isError(ret))
+      {
+        ABW_DEBUG_MSG(("ABWZstdDecompressor::decompress: %s\n", ZSTD_getErrorName(ret)));
+        return false;
+      }
+      if (control)
+        control->checkInflatedSize(buffer.size());
+    }
+  }
+
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  return 0 == ret;
+}
+
+#endif
+
+}
+
+ABWDecompressor::~ABWDecompressor()
+{
+}
+
+ABWDecompressor::Format ABWDecompressor::detectFormat(const unsigned char *const data, const unsigned long size)
+{
+  static const unsigned char gzipMagic[] = { 0x1f, 0x8b };
+  static const unsigned char xzMagic[] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+  static const unsigned char zstdMagic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+  if (!data)
+    return FORMAT_NONE;
+  if (size >= sizeof(gzipMagic) && memcmp(data, gzipMagic, sizeof(gzipMagic)) == 0)
+    return FORMAT_GZIP;
+  if (size >= sizeof(xzMagic) && memcmp(data, xzMagic, sizeof(xzMagic)) == 0)
+    return FORMAT_XZ;
+  if (size >= sizeof(zstdMagic) && memcmp(data, zstdMagic, sizeof(zstdMagic)) == 0)
+    return FORMAT_ZSTD;
+  return FORMAT_NONE;
+}
+
+ABWDecompressor::Format ABWDecompressor::getFormat(const Backend backend)
+{
+  switch (backend)
+  {
+  case BACKEND_INFLATE:
+  case BACKEND_LIBDEFLATE:
+    return FORMAT_GZIP;
+  case BACKEND_XZ:
+    return FORMAT_XZ;
+  case BACKEND_ZSTD:
+    return FORMAT_ZSTD;
+  default:
+    break;
+  }
+  return FORMAT_NONE;
+}
+
+bool ABWDecompressor::isAvailable(const Backend backend)
+{
+  switch (backend)
+  {
+  case BACKEND_INFLATE:
+    return true;
+  case BACKEND_LIBDEFLATE:
+#ifdef HAVE_LIBDEFLATE
+    return true;
+#else
+    return false;
+#endif
+  case BACKEND_XZ:
+#ifdef HAVE_LZMA
+    return true;
+#else
+    return false;
+#endif
+  case BACKEND_ZSTD:
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+  default:
+    break;
+  }
+  return false;
+}
+
+std::unique_ptr<ABWDecompressor> ABWDecompressor::create(const Backend backend)
+{
+  switch (backend)
+  {
+  case BACKEND_INFLATE:
+    return std::unique_ptr<ABWDecompressor>(new ABWInflateDecompressor());
+#ifdef HAVE_LIBDEFLATE
+  case BACKEND_LIBDEFLATE:
+    return std::unique_ptr<ABWDecompressor>(new ABWLibdeflateDecompressor());
+#endif
+#ifdef HAVE_LZMA
+  case BACKEND_XZ:
+    return std::unique_ptr<ABWDecompressor>(new ABWXzDecompressor());
+#endif
+#ifdef HAVE_ZSTD
+  case BACKEND_ZSTD:
+    return std::unique_ptr<ABWDecompressor>(new ABWZstdDecompressor());
+#endif
+  default:
+    break;
+  }
+  return std::unique_ptr<ABWDecompressor>();
+}
+
+std::unique_ptr<ABWDecompressor> ABWDecompressor::create(const Format format, const unsigned long size)
+{
+  switch (format)
+  {
+  case FORMAT_GZIP:
+    if (size && isAvailable(BACKEND_LIBDEFLATE))
+      return create(BACKEND_LIBDEFLATE);
+    return create(BACKEND_INFLATE);
+  case FORMAT_XZ:
+    return create(BACKEND_XZ);
+  case FORMAT_ZSTD:
+    return create(BACKEND_ZSTD);
+  default:
+    break;
+  }
+  return std::unique_ptr<ABWDecompressor>();
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,76 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWDECOMPRESSOR_H__
+#define __ABWDECOMPRESSOR_H__
+
+#include <memory>
+#include <vector>
+#include <librevenge-stream/librevenge-stream.h>
+
+namespace libabw
+{
+
+class ABWParseControl;
+
+/** Decompresses a whole compressed document into memory.
+
+    gzip documents are handled by the inflate backend, which uses zlib,
+    or zlib-ng if libabw was configured --with-zlib-ng. The libdeflate
+    backend, available if libabw was configured --with-libdeflate,
+    decompresses them in one call, but needs the whole input and the
+    exact inflated size. xz and zstd documents are supported if libabw
+    was configured --with-xz or --with-zstd, respectively.
+  */
+class ABWDecompressor
+{
+public:
+  enum Backend
+  {
+    BACKEND_INFLATE,
+    BACKEND_LIBDEFLATE,
+    BACKEND_XZ,
+    BACKEND_ZSTD
+  };
+
+  enum Format
+  {
+    FORMAT_NONE,
+    FORMAT_GZIP,
+    FORMAT_XZ,
+    FORMAT_ZSTD
+  };
+
+  virtual ~ABWDecompressor();
+
+  /** Decompresses the input to buffer.
+
+      \param size the decompressed size, if it is known from the input; 0 otherwise
+      \return false if the input is not in the expected format, is corrupted or does not match size
+    */
+  virtual bool decompress(librevenge::RVNGInputStream *input, unsigned long size,
+                          std::vector<unsigned char> &buffer, ABWParseControl *control) = 0;
+  virtual Backend getBackend() const = 0;
+  virtual const char *getName() const = 0;
+
+  //! the format of the data, recognized by its magic number
+  static Format detectFormat(const unsigned char *data, unsigned long size);
+  //! the format a backend decompresses
+  static Format getFormat(Backend backend);
+  static bool isAvailable(Backend backend);
+  //! the backend, or nullptr if it is not available
+  static std::unique_ptr<ABWDecompressor> create(Backend backend);
+  //! the fastest available backend for the format and the decompressed size, or nullptr
+  static std::unique_ptr<ABWDecompressor> create(Format format, unsigned long size);
+};
+
+} // namespace libabw
+
+#endif // __ABWDECOMPRESSOR_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,356 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "ABWDocumentLayout.h"
+#include "ABWXMLTokenMap.h"
+
+namespace libabw
+{
+
+namespace
+{
+
+bool isBlank(const unsigned char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isNameEnd(const unsigned char c)
+{
+  return isBlank(c) || c == '/' || c == '>' || c == '=' || c == '<';
+}
+
+//! Scans the markup of a well-formed document.
+class ABWLayoutScanner
+{
+public:
+  ABWLayoutScanner(const unsigned char *data, unsigned long size);
+
+  bool scan(ABWDocumentLayout &layout);
+
+private:
+  ABWLayoutScanner(const ABWLayoutScanner &);
+  ABWLayoutScanner &operator=(const ABWLayoutScanner &);
+
+  bool isAt(const char *str) const;
+  //! move past the next occurrence of str
+  bool skipPast(const char *str);
+  void skipBlanks();
+  //! move to the next '<'
+  bool findMarkup();
+  //! whether the position is at a comment, a processing instruction or a CDATA section
+  bool isAtIgnoredMarkup() const;
+  bool skipIgnoredMarkup();
+  //! read the name of a tag, the position is after the '<' or '</'
+  std::string readName();
+  //! move past the end of a tag, whose name was read
+  bool skipTag(bool &isEmpty);
+
+  bool readProlog();
+  bool readRootStartTag(ABWDocumentLayout &layout);
+  bool readElement(ABWTopLevelElement &element);
+
+  const unsigned char *const m_data;
+  const unsigned long m_size;
+  unsigned long m_pos;
+};
+
+ABWLayoutScanner::ABWLayoutScanner(const unsigned char *const data, const unsigned long size)
+  : m_data(data)
+  , m_size(size)
+  , m_pos(0)
+{
+}
+
+bool ABWLayoutScanner::isAt(const char *const str) const
+{
+  const unsigned long length = strlen(str);
+  return m_size - m_pos >= length && memcmp(m_data + m_pos, str, length) == 0;
+}
+
+bool ABWLayoutScanner::skipPast(const char *const str)
+{
+  const unsigned long length = strlen(str);
+  const unsigned char *const end = m_data + m_size;
+  const unsigned char *const found = std::search(m_data + m_pos, end, str, str + length);
+  if (found == end)
+    return false;
+  m_pos = static_cast<unsigned long>(found - m_data) + length;
+  return true;
+}
+
+void ABWLayoutScanner::skipBlanks()
+{
+  while (m_pos < m_size && isBlank(m_data[m_pos]))
+    ++m_pos;
+}
+
+bool ABWLayoutScanner::findMarkup()
+{
+  const void *const found = memchr(m_data + m_pos, '<', m_size - m_pos);
+  if (!found)
+    return false;
+  m_pos = static_cast<unsigned long>(static_cast<const unsigned char *>(found) - m_data);
+  return true;
+}
+
+bool ABWLayoutScanner::isAtIgnoredMarkup() const
+{
+  return isAt("<!--") || isAt("<?") || isAt("<![CDATA[");
+}
+
+bool ABWLayoutScanner::skipIgnoredMarkup()
+{
+  if (isAt("<!--"))
+    return skipPast("-->");
+  if (isAt("<?"))
+    return skipPast("?>");
+  return skipPast("]]>");
+}
+
+std::string ABWLayoutScanner::readName()
+{
+  const unsigned long begin = m_pos;
+  while (m_pos < m_size && !isNameEnd(m_data[m_pos]))
+    ++m_pos;
+  return std::string(reinterpret_cast<const char *>(m_data) + begin, m_pos - begin);
+}
+
+bool ABWLayoutScanner::skipTag(bool &isEmpty)
+{
+  while (m_pos < m_size)
+  {
+    const unsigned char c = m_data[m_pos];
+    if (c == '"' || c == '\'')
+    {
+      const void *const quote = memchr(m_data + m_pos + 1, c, m_size - m_pos - 1);
+      if (!quote)
+        return false;
+      m_pos = static_cast<unsigned long>(static_cast<const unsigned char *>(quote) - m_data) + 1;
+    }
+    else if (c == '>')
+    {
+      isEmpty = m_data[m_pos - 1] == '/';
+      ++m_pos;
+      return true;
+    }
+    else if (c == '<')
+      return false;
+    else
+      ++m_pos;
+  }
+  return false;
+}
+
+bool ABWLayoutScanner::readProlog()
+{
+  if (isAt("\xef\xbb\xbf"))
+    m_pos += 3;
+  if (isAt("<?xml") && m_size - m_pos > 5 && isBlank(m_data[m_pos + 5]))
+  {
+    // only UTF-8 can be split at any '<'
+    const unsigned long begin = m_pos;
+    if (!skipPast("?>"))
+      return false;
+    const std::string declaration(reinterpret_cast<const char *>(m_data) + begin, m_pos - begin);
+    const std::size_t encoding = declaration.find("encoding");
+    if (encoding != std::string::npos)
+    {
+      const std::size_t quote = declaration.find_first_of("\"'", encoding);
+      if (quote == std::string::npos)
+        return false;
+      std::string value = declaration.substr(quote + 1, declaration.find(declaration[quote], quote + 1) - quote - 1);
+      std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+      if (value != "utf-8" && value != "utf8")
+        return false;
+    }
+  }
+
+  while (true)
+  {
+    skipBlanks();
+    if (m_pos >= m_size || m_data[m_pos] != '<')
+      return false;
+    if (isAt("<!--") || isAt("<?"))
+    {
+      if (!skipIgnoredMarkup())
+        return false;
+    }
+    else if (isAt("<!DOCTYPE"))
+    {
+      const unsigned long begin = m_pos;
+      m_pos += 9;
+      bool isEmpty = false;
+      if (!skipTag(isEmpty))
+        return false;
+      // an internal subset could declare entities with markup
+      if (memchr(m_data + begin, '[', m_pos - begin))
+        return false;
+    }
+    else
+      return m_pos + 1 < m_size && !isNameEnd(m_data[m_pos + 1]) && m_data[m_pos + 1] != '!';
+  }
+}
+
+bool ABWLayoutScanner::readRootStartTag(ABWDocumentLayout &layout)
+{
+  layout.m_rootBegin = m_pos;
+  ++m_pos;
+  const std::string name = readName();
+  if (name.empty())
+    return false;
+  layout.m_rootStartTag = "<" + name;
+  layout.m_rootEndTag = "</" + name + ">";
+
+  while (true)
+  {
+    skipBlanks();
+    if (isAt(">"))
+    {
+      ++m_pos;
+      return true;
+    }
+    // an empty root element has no content to split
+    const std::string attribute = readName();
+    if (attribute.empty())
+      return false;
+    skipBlanks();
+    if (!isAt("="))
+      return false;
+    ++m_pos;
+    skipBlanks();
+    if (m_pos >= m_size || (m_data[m_pos] != '"' && m_data[m_pos] != '\''))
+      return false;
+    const unsigned long valueBegin = m_pos;
+    const void *const quote = memchr(m_data + m_pos + 1, m_data[m_pos], m_size - m_pos - 1);
+    if (!quote)
+      return false;
+    m_pos = static_cast<unsigned long>(static_cast<const unsigned char *>(quote) - m_data) + 1;
+    if (attribute == "xmlns" || attribute.compare(0, 6, "xmlns:") == 0 || attribute.compare(0, 4, "xml:") == 0)
+    {
+      layout.m_rootStartTag += " " + attribute + "=";
+      layout.m_rootStartTag.append(reinterpret_cast<const char *>(m_data) + valueBegin, m_pos - valueBegin);
+    }
+  }
+}
+
+bool ABWLayoutScanner::readElement(ABWTopLevelElement &element)
+{
+  element.m_begin = m_pos;
+  ++m_pos;
+  const std::string name = readName();
+  bool isEmpty = false;
+  if (name.empty() || !skipTag(isEmpty))
+    return false;
+  element.m_startTagEnd = m_pos;
+  element.m_tokenId = ABWXMLTokenMap::getTokenId(reinterpret_cast<const xmlChar *>(name.c_str()));
+  element.m_isSection = name == "section";
+  element.m_tableCount = name == "table" ? 1 : 0;
+
+  unsigned long depth = isEmpty ? 0 : 1;
+  while (depth)
+  {
+    if (!findMarkup())
+      return false;
+    if (isAtIgnoredMarkup())
+    {
+      if (!skipIgnoredMarkup())
+        return false;
+    }
+    else if (isAt("</"))
+    {
+      const void *const end = memchr(m_data + m_pos, '>', m_size - m_pos);
+      if (!end)
+        return false;
+      m_pos = static_cast<unsigned long>(static_cast<const unsigned char *>(end) - m_data) + 1;
+      --depth;
+    }
+    else if (isAt("<!"))
+      return false;
+    else
+    {
+      ++m_pos;
+      const std::string childName = readName();
+      if (childName.empty() || !skipTag(isEmpty))
+        return false;
+      element.m_hasChildElements = true;
+      if (childName == "table")
+        ++element.m_tableCount;
+      if (!isEmpty)
+        ++depth;
+    }
+  }
+  element.m_end = m_pos;
+  return true;
+}
+
+bool ABWLayoutScanner::scan(ABWDocumentLayout &layout)
+{
+  if (!m_data || !readProlog() || !readRootStartTag(layout))
+    return false;
+
+  while (true)
+  {
+    // text between the children is left to the parser
+    if (!findMarkup())
+      return false;
+    if (isAtIgnoredMarkup())
+    {
+      if (!skipIgnoredMarkup())
+        return false;
+    }
+    else if (isAt("</"))
+      return true;
+    else if (isAt("<!"))
+      return false;
+    else
+    {
+      ABWTopLevelElement element;
+      if (!readElement(element))
+        return false;
+      layout.m_elements.push_back(element);
+    }
+  }
+}
+
+} // anonymous namespace
+
+ABWTopLevelElement::ABWTopLevelElement()
+  : m_begin(0)
+  , m_startTagEnd(0)
+  , m_end(0)
+  , m_tokenId(XML_TOKEN_INVALID)
+  , m_isSection(false)
+  , m_hasChildElements(false)
+  , m_tableCount(0)
+{
+}
+
+ABWDocumentLayout::ABWDocumentLayout()
+  : m_rootBegin(0)
+  , m_rootStartTag()
+  , m_rootEndTag()
+  , m_elements()
+{
+}
+
+bool findDocumentLayout(const unsigned char *const data, const unsigned long size, ABWDocumentLayout &layout)
+{
+  ABWLayoutScanner scanner(data, size);
+  return scanner.scan(layout);
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
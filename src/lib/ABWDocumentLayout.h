@@ -0,0 +1,68 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWDOCUMENTLAYOUT_H__
+#define __ABWDOCUMENTLAYOUT_H__
+
+#include <string>
+#include <vector>
+
+namespace libabw
+{
+
+//! A child element of the root element of an AWML document.
+struct ABWTopLevelElement
+{
+  ABWTopLevelElement();
+
+  //! the offset of the '<' of the start tag
+  unsigned long m_begin;
+  //! the offset after the start tag
+  unsigned long m_startTagEnd;
+  //! the offset after the end tag (or after the start tag of an empty element)
+  unsigned long m_end;
+  //! the token of the name of the element
+  int m_tokenId;
+  bool m_isSection;
+  //! whether the element contains other elements
+  bool m_hasChildElements;
+  //! number of <table> elements, including the element itself
+  int m_tableCount;
+};
+
+/** The structure of an AWML document down to the children of the root
+    element, as far as it is needed to split the content.
+  */
+struct ABWDocumentLayout
+{
+  ABWDocumentLayout();
+
+  //! the offset of the start tag of the root element
+  unsigned long m_rootBegin;
+  /** the start tag of the root element without the closing '>' and
+      without the attributes, except the namespace declarations and the
+      xml: attributes, which are inherited by the content
+    */
+  std::string m_rootStartTag;
+  std::string m_rootEndTag;
+  std::vector<ABWTopLevelElement> m_elements;
+};
+
+/** find the layout of the document in data, by a scan of the bytes
+
+    The document must be well-formed. Returns false if the layout cannot
+    be found that way, e.g., if the document is not in UTF-8 or has an
+    internal DTD subset, which could declare entities with markup.
+  */
+bool findDocumentLayout(const unsigned char *data, unsigned long size, ABWDocumentLayout &layout);
+
+} // namespace libabw
+
+#endif // __ABWDOCUMENTLAYOUT_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
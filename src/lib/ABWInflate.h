@@ -0,0 +1,43 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWINFLATE_H__
+#define __ABWINFLATE_H__
+
+/* The streaming inflate API used by libabw: zlib-ng's native one if
+   libabw was configured --with-zlib-ng, zlib's otherwise. Include it
+   after libabw_internal.h, which includes config.h. */
+
+#ifdef HAVE_ZLIB_NG
+#include <stdint.h>
+#include <zlib-ng.h>
+#define ABW_INFLATE_NAME "zlib-ng"
+typedef zng_stream ABWZStream;
+typedef uint32_t ABWZSize;
+#define abwInflateInit2 zng_inflateInit2
+#define abwInflate ::zng_inflate
+#define abwInflateEnd zng_inflateEnd
+#define abwInflatePrime zng_inflatePrime
+#define abwInflateSetDictionary zng_inflateSetDictionary
+#define abwInflateGetDictionary zng_inflateGetDictionary
+#else
+#include <zlib.h>
+#define ABW_INFLATE_NAME "zlib"
+typedef z_stream ABWZStream;
+typedef uInt ABWZSize;
+#define abwInflateInit2 inflateInit2
+#define abwInflate ::inflate
+#define abwInflateEnd inflateEnd
+#define abwInflatePrime inflatePrime
+#define abwInflateSetDictionary inflateSetDictionary
+#define abwInflateGetDictionary inflateGetDictionary
+#endif
+
+#endif // __ABWINFLATE_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
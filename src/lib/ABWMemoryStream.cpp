@@ -0,0 +1,75 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "ABWMemoryStream.h"
+
+namespace libabw
+{
+
+ABWMemoryStream::ABWMemoryStream(const unsigned char *const data, const unsigned long size)
+  : librevenge::RVNGInputStream()
+  , m_data(data)
+  , m_size(data ? size : 0)
+  , m_offset(0)
+{
+}
+
+ABWMemoryStream::~ABWMemoryStream()
+{
+}
+
+const unsigned char *ABWMemoryStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+{
+  numBytesRead = 0;
+  if (numBytes == 0 || m_offset >= m_size)
+    return nullptr;
+
+  const unsigned long remaining = m_size - m_offset;
+  numBytesRead = numBytes < remaining ? numBytes : remaining;
+  const unsigned char *const data = m_data + m_offset;
+  m_offset += numBytesRead;
+  return data;
+}
+
+int ABWMemoryStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+{
+  long pos = offset;
+  if (seekType == librevenge::RVNG_SEEK_CUR)
+    pos += long(m_offset);
+  else if (seekType == librevenge::RVNG_SEEK_END)
+    pos += long(m_size);
+
+  if (pos < 0)
+  {
+    m_offset = 0;
+    return 1;
+  }
+  if (pos > long(m_size))
+  {
+    m_offset = m_size;
+    return 1;
+  }
+
+  m_offset = static_cast<unsigned long>(pos);
+  return 0;
+}
+
+long ABWMemoryStream::tell()
+{
+  return long(m_offset);
+}
+
+bool ABWMemoryStream::isEnd()
+{
+  return m_offset >= m_size;
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
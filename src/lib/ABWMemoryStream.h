@@ -0,0 +1,79 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWMEMORYSTREAM_H__
+#define __ABWMEMORYSTREAM_H__
+
+#include <librevenge-stream/librevenge-stream.h>
+
+namespace libabw
+{
+
+/** Input stream reading a document in memory, which it does not own.
+
+    libxml2 parses the document in place, like the other streams whose
+    data are in memory.
+  */
+class ABWMemoryStream : public librevenge::RVNGInputStream
+{
+public:
+  ABWMemoryStream(const unsigned char *data, unsigned long size);
+  ~ABWMemoryStream() override;
+
+  bool isStructured() override
+  {
+    return false;
+  }
+  unsigned subStreamCount() override
+  {
+    return 0;
+  }
+  const char *subStreamName(unsigned) override
+  {
+    return nullptr;
+  }
+  bool existsSubStream(const char *) override
+  {
+    return false;
+  }
+  librevenge::RVNGInputStream *getSubStreamByName(const char *) override
+  {
+    return nullptr;
+  }
+  librevenge::RVNGInputStream *getSubStreamById(unsigned) override
+  {
+    return nullptr;
+  }
+  const unsigned char *read(unsigned long numBytes, unsigned long &numBytesRead) override;
+  int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
+  long tell() override;
+  bool isEnd() override;
+
+  const unsigned char *getData() const
+  {
+    return m_data;
+  }
+  unsigned long getSize() const
+  {
+    return m_size;
+  }
+
+private:
+  ABWMemoryStream(const ABWMemoryStream &);
+  ABWMemoryStream &operator=(const ABWMemoryStream &);
+
+  const unsigned char *m_data;
+  unsigned long m_size;
+  unsigned long m_offset;
+};
+
+} // namespace libabw
+
+#endif // __ABWMEMORYSTREAM_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,65 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <cassert>
+
+#include "ABWMetadataCollector.h"
+#include "ABWXMLTokenMap.h"
+
+libabw::ABWMetadataCollector::ABWMetadataCollector(ABWPropertyMap &metadata)
+  : m_metadata(metadata)
+  , m_isFinished(false)
+{
+}
+
+libabw::ABWMetadataCollector::~ABWMetadataCollector()
+{
+}
+
+void libabw::ABWMetadataCollector::collectSectionProperties(const char *, const char *, const char *, const char *,
+                                                            const char *, const char *, const char *, const char *,
+                                                            const char *)
+{
+  m_isFinished = true;
+}
+
+void libabw::ABWMetadataCollector::collectHeaderFooter(const char *, const char *)
+{
+  m_isFinished = true;
+}
+
+void libabw::ABWMetadataCollector::addMetadataEntry(const char *const key, const char *const value)
+{
+  assert(key);
+  assert(value);
+
+  m_metadata[key] = value;
+}
+
+bool libabw::ABWMetadataCollector::isElementIgnored(const int tokenId) const
+{
+  switch (tokenId)
+  {
+  case XML_ABIWORD:
+  case XML_AWML:
+  case XML_METADATA:
+  case XML_M:
+  case XML_SECTION:
+    return false;
+  default:
+    return true;
+  }
+}
+
+bool libabw::ABWMetadataCollector::isFinished() const
+{
+  return m_isFinished;
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,91 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWMETADATACOLLECTOR_H__
+#define __ABWMETADATACOLLECTOR_H__
+
+#include <librevenge/librevenge.h>
+#include "ABWCollector.h"
+
+namespace libabw
+{
+
+/** Collects the metadata of a document, and nothing else.
+
+    The metadata precede the content, so the collector is finished at
+    the first section.
+  */
+class ABWMetadataCollector : public ABWCollector
+{
+public:
+  explicit ABWMetadataCollector(ABWPropertyMap &metadata);
+  ~ABWMetadataCollector() override;
+
+  // collector functions
+
+  void collectTextStyle(const char *, const char *, const char *, const char *) override {}
+  void collectDocumentProperties(const char *) override {}
+  void collectParagraphProperties(const char *, const char *, const char *, const char *, const char *) override {}
+  void collectSectionProperties(const char *, const char *, const char *, const char *,
+                                const char *, const char *, const char *, const char *,
+                                const char *) override;
+  void collectCharacterProperties(const char *, const char *) override {}
+  void collectPageSize(const char *, const char *, const char *, const char *) override {}
+  void closeParagraphOrListElement() override {}
+  void closeSpan() override {}
+  void openLink(const char *) override {}
+  void closeLink() override {}
+  void openFoot(const char *) override {}
+  void closeFoot() override {}
+  void openEndnote(const char *) override {}
+  void closeEndnote() override {}
+  void openField(const char *, const char *) override {}
+  void closeField() override {}
+  void endSection() override {}
+  void startDocument() override {}
+  void endDocument() override {}
+  void insertLineBreak() override {}
+  void insertColumnBreak() override {}
+  void insertPageBreak() override {}
+  void insertText(const char *) override {}
+  void insertImage(const char *, const char *) override {}
+
+  void collectData(const char *, const char *, const librevenge::RVNGBinaryData &) override {}
+  void collectHeaderFooter(const char *, const char *) override;
+  void collectList(const char *, const char *, const char *, const char *, const char *, const char *) override {}
+
+  void openTable(const char *) override {}
+  void closeTable() override {}
+  void openCell(const char *) override {}
+  void closeCell() override {}
+
+  void openFrame(const char *, const char *, const char *, const char *) override {}
+  void closeFrame(ABWOutputElements *(&elements), bool &) override
+  {
+    elements=nullptr;
+  }
+  void addFrameElements(ABWOutputElements &, bool) override {}
+
+  void addMetadataEntry(const char *name, const char *value) override;
+
+  bool isElementIgnored(int tokenId) const override;
+  bool isFinished() const override;
+
+private:
+  ABWMetadataCollector(const ABWMetadataCollector &);
+  ABWMetadataCollector &operator=(const ABWMetadataCollector &);
+
+  ABWPropertyMap &m_metadata;
+  bool m_isFinished;
+};
+
+} // namespace libabw
+
+#endif /* __ABWMETADATACOLLECTOR_H__ */
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
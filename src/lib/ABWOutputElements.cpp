@@ -7,7 +7,10 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <utility>
+
 #include "ABWOutputElements.h"
+#include "ABWParseControl.h"
 
 namespace
 {
@@ -890,8 +893,8 @@ void libabw::ABWOpenUnorderedListLevelElement::write(librevenge::RVNGTextInterfa
 
 // ABWOutputElements
 
-libabw::ABWOutputElements::ABWOutputElements()
-  : m_bodyElements(), m_headerElements(), m_footerElements(), m_elements(nullptr)
+libabw::ABWOutputElements::ABWOutputElements(ABWParseControl *control)
+  : m_bodyElements(), m_headerElements(), m_footerElements(), m_elements(nullptr), m_control(control)
 {
   m_elements = &m_bodyElements;
 }
@@ -905,163 +908,199 @@ void libabw::ABWOutputElements::splice(ABWOutputElements &elements)
   m_bodyElements.splice(m_bodyElements.end(), elements.m_bodyElements);
 }
 
-void libabw::ABWOutputElements::write(librevenge::RVNGTextInterface *iface) const
+void libabw::ABWOutputElements::spliceAll(ABWOutputElements &elements)
+{
+  m_bodyElements.splice(m_bodyElements.end(), elements.m_bodyElements);
+  for (auto &header : elements.m_headerElements)
+  {
+    OutputElements_t &headerElements = m_headerElements[header.first];
+    headerElements.splice(headerElements.end(), header.second);
+  }
+  for (auto &footer : elements.m_footerElements)
+  {
+    OutputElements_t &footerElements = m_footerElements[footer.first];
+    footerElements.splice(footerElements.end(), footer.second);
+  }
+  elements.clear();
+}
+
+void libabw::ABWOutputElements::swap(ABWOutputElements &elements)
+{
+  m_bodyElements.swap(elements.m_bodyElements);
+  m_headerElements.swap(elements.m_headerElements);
+  m_footerElements.swap(elements.m_footerElements);
+  std::swap(m_elements, elements.m_elements);
+  // the header and footer lists move with their map nodes, but the
+  // body lists only exchange their content
+  if (m_elements == &elements.m_bodyElements)
+    m_elements = &m_bodyElements;
+  if (elements.m_elements == &m_bodyElements)
+    elements.m_elements = &elements.m_bodyElements;
+}
+
+void libabw::ABWOutputElements::clear()
+{
+  m_bodyElements.clear();
+  m_headerElements.clear();
+  m_footerElements.clear();
+  m_elements = &m_bodyElements;
+}
+
+void libabw::ABWOutputElements::write(librevenge::RVNGTextInterface *iface, ABWParseControl *control) const
 {
   OutputElements_t::const_iterator iter;
   for (iter = m_bodyElements.begin(); iter != m_bodyElements.end(); ++iter)
+  {
+    if (control)
+      control->checkCancelled();
     (*iter)->write(iface, &m_footerElements, &m_headerElements);
+  }
+}
+
+void libabw::ABWOutputElements::append(std::unique_ptr<ABWOutputElement> &&element)
+{
+  if (!m_elements)
+    return;
+  if (m_control)
+    m_control->addOutputElement();
+  m_elements->push_back(std::move(element));
+}
+
+std::size_t libabw::ABWOutputElements::size() const
+{
+  std::size_t count = m_bodyElements.size();
+  for (const auto &header : m_headerElements)
+    count += header.second.size();
+  for (const auto &footer : m_footerElements)
+    count += footer.second.size();
+  return count;
 }
 
 void libabw::ABWOutputElements::addCloseEndnote()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseEndnoteElement>());
+  append(make_unique<ABWCloseEndnoteElement>());
 }
 
 void libabw::ABWOutputElements::addCloseFooter()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseFooterElement>());
+  append(make_unique<ABWCloseFooterElement>());
   m_elements = &m_bodyElements;
 }
 
 void libabw::ABWOutputElements::addCloseFootnote()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseFootnoteElement>());
+  append(make_unique<ABWCloseFootnoteElement>());
 }
 
 void libabw::ABWOutputElements::addCloseFrame()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseFrameElement>());
+  append(make_unique<ABWCloseFrameElement>());
 }
 
 void libabw::ABWOutputElements::addCloseHeader()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseHeaderElement>());
+  append(make_unique<ABWCloseHeaderElement>());
   m_elements = &m_bodyElements;
 }
 
 void libabw::ABWOutputElements::addCloseLink()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseLinkElement>());
+  append(make_unique<ABWCloseLinkElement>());
 }
 
 void libabw::ABWOutputElements::addCloseListElement()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseListElementElement>());
+  append(make_unique<ABWCloseListElementElement>());
 }
 
 void libabw::ABWOutputElements::addCloseOrderedListLevel()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseOrderedListLevelElement>());
+  append(make_unique<ABWCloseOrderedListLevelElement>());
 }
 
 void libabw::ABWOutputElements::addClosePageSpan()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWClosePageSpanElement>());
+  append(make_unique<ABWClosePageSpanElement>());
 }
 
 void libabw::ABWOutputElements::addCloseParagraph()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseParagraphElement>());
+  append(make_unique<ABWCloseParagraphElement>());
 }
 
 void libabw::ABWOutputElements::addCloseSection()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseSectionElement>());
+  append(make_unique<ABWCloseSectionElement>());
 }
 
 void libabw::ABWOutputElements::addCloseSpan()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseSpanElement>());
+  append(make_unique<ABWCloseSpanElement>());
 }
 
 void libabw::ABWOutputElements::addCloseTable()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseTableElement>());
+  append(make_unique<ABWCloseTableElement>());
 }
 
 void libabw::ABWOutputElements::addCloseTableCell()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseTableCellElement>());
+  append(make_unique<ABWCloseTableCellElement>());
 }
 
 void libabw::ABWOutputElements::addCloseTableRow()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseTableRowElement>());
+  append(make_unique<ABWCloseTableRowElement>());
 }
 
 void libabw::ABWOutputElements::addCloseTextBox()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseTextBoxElement>());
+  append(make_unique<ABWCloseTextBoxElement>());
 }
 
 void libabw::ABWOutputElements::addCloseUnorderedListLevel()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWCloseUnorderedListLevelElement>());
+  append(make_unique<ABWCloseUnorderedListLevelElement>());
 }
 
 void libabw::ABWOutputElements::addInsertBinaryObject(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertBinaryObjectElement>(propList));
+  append(make_unique<ABWInsertBinaryObjectElement>(propList));
 }
 
 void libabw::ABWOutputElements::addInsertField(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertFieldElement>(propList));
+  append(make_unique<ABWInsertFieldElement>(propList));
 }
 
 void libabw::ABWOutputElements::addInsertCoveredTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertCoveredTableCellElement>(propList));
+  append(make_unique<ABWInsertCoveredTableCellElement>(propList));
 }
 
 void libabw::ABWOutputElements::addInsertLineBreak()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertLineBreakElement>());
+  append(make_unique<ABWInsertLineBreakElement>());
 }
 
 void libabw::ABWOutputElements::addInsertSpace()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertSpaceElement>());
+  append(make_unique<ABWInsertSpaceElement>());
 }
 
 void libabw::ABWOutputElements::addInsertTab()
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertTabElement>());
+  append(make_unique<ABWInsertTabElement>());
 }
 
 void libabw::ABWOutputElements::addInsertText(const librevenge::RVNGString &text)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWInsertTextElement>(text));
+  append(make_unique<ABWInsertTextElement>(text));
 }
 
 void libabw::ABWOutputElements::addOpenEndnote(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenEndnoteElement>(propList));
+  append(make_unique<ABWOpenEndnoteElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenFooter(const librevenge::RVNGPropertyList &propList, int id)
@@ -1071,103 +1110,87 @@ void libabw::ABWOutputElements::addOpenFooter(const librevenge::RVNGPropertyList
   // already exists, this might be a footer with different occurrence and we will add it to
   // the existing one.
   m_elements = &m_footerElements[id];
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenFooterElement>(propList));
+  append(make_unique<ABWOpenFooterElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenFootnote(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenFootnoteElement>(propList));
+  append(make_unique<ABWOpenFootnoteElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenFrame(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenFrameElement>(propList));
+  append(make_unique<ABWOpenFrameElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenHeader(const librevenge::RVNGPropertyList &propList, int id)
 {
   // Check the comment in addOpenFooter to see what happens here
   m_elements = &m_headerElements[id];
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenHeaderElement>(propList));
+  append(make_unique<ABWOpenHeaderElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenListElement(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenListElementElement>(propList));
+  append(make_unique<ABWOpenListElementElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenLink(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenLinkElement>(propList));
+  append(make_unique<ABWOpenLinkElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenOrderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenOrderedListLevelElement>(propList));
+  append(make_unique<ABWOpenOrderedListLevelElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenPageSpan(const librevenge::RVNGPropertyList &propList,
                                                 int footer, int footerLeft, int footerFirst, int footerLast,
                                                 int header, int headerLeft, int headerFirst, int headerLast)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenPageSpanElement>(propList, footer, footerLeft, footerFirst, footerLast,
-                                                              header, headerLeft, headerFirst, headerLast));
+  append(make_unique<ABWOpenPageSpanElement>(propList, footer, footerLeft, footerFirst, footerLast,
+                                             header, headerLeft, headerFirst, headerLast));
 }
 
 void libabw::ABWOutputElements::addOpenParagraph(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenParagraphElement>(propList));
+  append(make_unique<ABWOpenParagraphElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenSection(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenSectionElement>(propList));
+  append(make_unique<ABWOpenSectionElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenSpan(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenSpanElement>(propList));
+  append(make_unique<ABWOpenSpanElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenTable(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenTableElement>(propList));
+  append(make_unique<ABWOpenTableElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenTableCell(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenTableCellElement>(propList));
+  append(make_unique<ABWOpenTableCellElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenTableRow(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenTableRowElement>(propList));
+  append(make_unique<ABWOpenTableRowElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenTextBox(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenTextBoxElement>(propList));
+  append(make_unique<ABWOpenTextBoxElement>(propList));
 }
 
 void libabw::ABWOutputElements::addOpenUnorderedListLevel(const librevenge::RVNGPropertyList &propList)
 {
-  if (m_elements)
-    m_elements->push_back(make_unique<ABWOpenUnorderedListLevelElement>(propList));
+  append(make_unique<ABWOpenUnorderedListLevelElement>(propList));
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -20,6 +20,7 @@ namespace libabw
 {
 
 class ABWOutputElement;
+class ABWParseControl;
 
 class ABWOutputElements
 {
@@ -27,10 +28,16 @@ public:
   typedef std::list<std::unique_ptr<ABWOutputElement>> OutputElements_t;
   typedef std::map<int, OutputElements_t> OutputElementsMap_t;
 
-  ABWOutputElements();
+  explicit ABWOutputElements(ABWParseControl *control = nullptr);
   virtual ~ABWOutputElements();
   void splice(ABWOutputElements &elements);
-  void write(librevenge::RVNGTextInterface *iface) const;
+  //! move the elements, including the headers and the footers, to the end of this
+  void spliceAll(ABWOutputElements &elements);
+  //! exchange the content, including the current insertion point, with elements
+  void swap(ABWOutputElements &elements);
+  //! remove all the elements and reset the insertion point to the body
+  void clear();
+  void write(librevenge::RVNGTextInterface *iface, ABWParseControl *control = nullptr) const;
   void addCloseEndnote();
   void addCloseFooter();
   void addCloseFootnote();
@@ -79,13 +86,22 @@ public:
   {
     return m_bodyElements.empty();
   }
+  //! whether the elements are added to the body, not to a header or a footer
+  bool isInBody() const
+  {
+    return m_elements == &m_bodyElements;
+  }
+  //! number of elements in the body, the headers and the footers
+  std::size_t size() const;
 private:
   ABWOutputElements(const ABWOutputElements &);
   ABWOutputElements &operator=(const ABWOutputElements &);
+  void append(std::unique_ptr<ABWOutputElement> &&element);
   OutputElements_t m_bodyElements;
   std::map<int, OutputElements_t > m_headerElements;
   std::map<int, OutputElements_t > m_footerElements;
   OutputElements_t *m_elements;
+  ABWParseControl *m_control;
 };
 
 
@@ -0,0 +1,103 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <utility>
+
+#include "ABWParseControl.h"
+#include "libabw_internal.h"
+
+libabw::ABWSharedBudget::ABWSharedBudget()
+  : m_nodes(0)
+  , m_outputElements(0)
+{
+}
+
+libabw::ABWParseControl::ABWParseControl()
+  : m_cancel(nullptr)
+  , m_deadline(std::chrono::steady_clock::time_point::max())
+  , m_hasDeadline(false)
+  , m_checkCount(0)
+  , m_limits()
+  , m_dataBytes(0)
+  , m_outputElements(0)
+  , m_deferred()
+  , m_budget(nullptr)
+  , m_budgetNodeCount(0)
+{
+}
+
+libabw::ABWParseControl::ABWParseControl(const AbiParseOptions &options)
+  : ABWParseControl()
+{
+  restart(options);
+}
+
+void libabw::ABWParseControl::restart(const AbiParseOptions &options)
+{
+  m_cancel = options.m_cancel;
+  m_deadline = options.m_deadline;
+  m_hasDeadline = options.m_deadline != std::chrono::steady_clock::time_point::max();
+  m_checkCount = 0;
+  m_limits = options.m_limits;
+  m_dataBytes = 0;
+  m_outputElements = 0;
+  m_deferred = std::exception_ptr();
+  m_budget = nullptr;
+  m_budgetNodeCount = 0;
+  // do not start a parse that is already late
+  if (m_hasDeadline)
+    checkDeadline();
+}
+
+void libabw::ABWParseControl::copySettings(const ABWParseControl &control)
+{
+  m_deadline = control.m_deadline;
+  m_hasDeadline = control.m_hasDeadline;
+  m_limits = control.m_limits;
+}
+
+void libabw::ABWParseControl::shareBudget(ABWSharedBudget *const budget)
+{
+  m_budget = budget;
+  m_budgetNodeCount = 0;
+}
+
+void libabw::ABWParseControl::addBudgetNodes(const unsigned long count)
+{
+  // a new pass starts from 0
+  const unsigned long added = count >= m_budgetNodeCount ? count - m_budgetNodeCount : count;
+  m_budgetNodeCount = count;
+  if (m_limits.m_maxNodes && m_budget->m_nodes.fetch_add(added, std::memory_order_relaxed) + added > m_limits.m_maxNodes)
+    limitExceeded("number of XML nodes");
+}
+
+void libabw::ABWParseControl::checkDeadline() const
+{
+  if (std::chrono::steady_clock::now() >= m_deadline)
+  {
+    ABW_DEBUG_MSG(("ABWParseControl::checkDeadline: the deadline has passed\n"));
+    throw ABWCancelledException();
+  }
+}
+
+void libabw::ABWParseControl::limitExceeded(const char *what) const
+{
+  ABW_DEBUG_MSG(("ABWParseControl: the document exceeds the limit on %s\n", what));
+  (void)what;
+  throw ABWLimitExceededException();
+}
+
+void libabw::ABWParseControl::rethrowDeferred()
+{
+  std::exception_ptr exception;
+  std::swap(exception, m_deferred);
+  std::rethrow_exception(exception);
+}
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,168 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWPARSECONTROL_H__
+#define __ABWPARSECONTROL_H__
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+
+#include <libabw/AbiParseOptions.h>
+
+namespace libabw
+{
+
+//! Thrown when the parsing has been cancelled or its deadline has passed.
+class ABWCancelledException
+{
+};
+
+//! Thrown when the document exceeds one of the resource limits.
+class ABWLimitExceededException
+{
+};
+
+/** The nodes and the output elements of the parts of a parse on other threads.
+
+    The controls of the parts count into it as well, so that the parts
+    together stay within the limits, however many are parsed at once.
+  */
+struct ABWSharedBudget
+{
+  ABWSharedBudget();
+
+  std::atomic<unsigned long> m_nodes;
+  std::atomic<unsigned long> m_outputElements;
+};
+
+/** Decides whether a running parse should be aborted.
+
+    The cancellation flag is checked on every call of checkCancelled(),
+    the clock only on every DEADLINE_CHECK_INTERVAL-th call. The other
+    check functions enforce the resource limits.
+
+    Code called back from libxml2 must not throw; it defers the abort
+    instead, and the next checkCancelled() rethrows it.
+  */
+class ABWParseControl
+{
+public:
+  ABWParseControl();
+  explicit ABWParseControl(const AbiParseOptions &options);
+
+  ABWParseControl(const ABWParseControl &) = delete;
+  ABWParseControl &operator=(const ABWParseControl &) = delete;
+
+  //! start another parse, with the cancellation, the deadline and the limits of options
+  void restart(const AbiParseOptions &options);
+  //! use the deadline and the limits of control, e.g., for a part of its parsing on another thread
+  void copySettings(const ABWParseControl &control);
+  //! count the nodes and the output elements from now on into budget too
+  void shareBudget(ABWSharedBudget *budget);
+
+  //! throws ABWCancelledException if the parsing should stop
+  void checkCancelled()
+  {
+    if (m_deferred)
+      rethrowDeferred();
+    if (m_cancel && m_cancel->load(std::memory_order_relaxed))
+      throw ABWCancelledException();
+    if (m_hasDeadline && ++m_checkCount % DEADLINE_CHECK_INTERVAL == 0)
+      checkDeadline();
+  }
+
+  void checkInflatedSize(unsigned long size) const
+  {
+    if (m_limits.m_maxInflatedBytes && size > m_limits.m_maxInflatedBytes)
+      limitExceeded("decompressed size");
+  }
+
+  void checkDepth(unsigned long depth) const
+  {
+    if (m_limits.m_maxDepth && depth > m_limits.m_maxDepth)
+      limitExceeded("XML depth");
+  }
+
+  //! count is the number of nodes of the current pass
+  void checkNodeCount(unsigned long count)
+  {
+    if (m_budget)
+      addBudgetNodes(count);
+    if (m_limits.m_maxNodes && count > m_limits.m_maxNodes)
+      limitExceeded("number of XML nodes");
+  }
+
+  //! the decompression of the document needs more memory than it may use
+  void decoderMemoryExceeded() const
+  {
+    limitExceeded("memory of the decompression");
+  }
+
+  //! throws if adding bytes of data would exceed the limit; adds nothing
+  void checkDataBytes(unsigned long bytes) const
+  {
+    if (m_limits.m_maxDataBytes && (m_dataBytes > m_limits.m_maxDataBytes || bytes > m_limits.m_maxDataBytes - m_dataBytes))
+      limitExceeded("size of embedded data");
+  }
+
+  void addDataBytes(unsigned long bytes)
+  {
+    m_dataBytes += bytes;
+    if (m_limits.m_maxDataBytes && m_dataBytes > m_limits.m_maxDataBytes)
+      limitExceeded("size of embedded data");
+  }
+
+  void addOutputElement()
+  {
+    addOutputElements(1);
+  }
+
+  void addOutputElements(unsigned long count)
+  {
+    m_outputElements += count;
+    if (m_limits.m_maxOutputElements && m_outputElements > m_limits.m_maxOutputElements)
+      limitExceeded("number of output elements");
+    if (m_budget && m_limits.m_maxOutputElements
+        && m_budget->m_outputElements.fetch_add(count, std::memory_order_relaxed) + count > m_limits.m_maxOutputElements)
+      limitExceeded("number of output elements");
+  }
+
+  //! keep an exception thrown where it could not be propagated
+  void deferException(std::exception_ptr exception)
+  {
+    if (!m_deferred)
+      m_deferred = exception;
+  }
+
+private:
+  enum { DEADLINE_CHECK_INTERVAL = 256 };
+
+  void checkDeadline() const;
+  void limitExceeded(const char *what) const;
+  void rethrowDeferred();
+  void addBudgetNodes(unsigned long count);
+
+  const std::atomic<bool> *m_cancel;
+  std::chrono::steady_clock::time_point m_deadline;
+  bool m_hasDeadline;
+  unsigned m_checkCount;
+  AbiParseLimits m_limits;
+  unsigned long m_dataBytes;
+  unsigned long m_outputElements;
+  std::exception_ptr m_deferred;
+  ABWSharedBudget *m_budget;
+  //! the node count of the pass that was last counted into m_budget
+  unsigned long m_budgetNodeCount;
+};
+
+} // namespace libabw
+
+#endif // __ABWPARSECONTROL_H__
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
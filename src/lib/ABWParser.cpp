@@ -9,16 +9,31 @@
 
 #include <string.h>
 
-#include <set>
-#include <stack>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <libxml/xmlIO.h>
 #include <libxml/xmlstring.h>
+#include <libxml/xmlversion.h>
 #include <librevenge-stream/librevenge-stream.h>
 #include <boost/spirit/include/qi.hpp>
 #include "ABWParser.h"
+#include "ABWParseControl.h"
 #include "ABWContentCollector.h"
+#include "ABWDataDecoder.h"
+#include "ABWDocumentLayout.h"
+#include "ABWMemoryStream.h"
+#include "ABWMetadataCollector.h"
 #include "ABWStylesCollector.h"
 #include "libabw_internal.h"
 #include "ABWXMLHelper.h"
@@ -56,47 +71,270 @@ static xmlChar *call_BAD_CAST_OnConst(char const *str)
   return BAD_CAST(const_cast<char *>(str));
 }
 
-/** try to find the parent's level corresponding to a level with some id
-    and use its original id to define the list id.
+/** try to update the final list id for each list elements
 
-    Seen corresponds to the list of level that we have already examined,
-    it is used to check also for loop
+    The final id of a list element is the id of the root of its chain
+    of parents. The chains are followed iteratively over a vector of the
+    elements, and every element met along a chain gets the root's id.
+
+    An element that is met again while it still has no id becomes a
+    root: either the chain loops, or it led to an unknown parent the
+    first time, which gave its elements the id 0. So each element is
+    visited at most twice.
+  */
+static void updateListElementIds(std::map<int, std::shared_ptr<ABWListElement>> &listElements)
+{
+  struct Node
+  {
+    ABWListElement *m_element;
+    int m_id;
+    //! the index of the parent, or -1 if the parent is unknown
+    int m_parent;
+    bool m_isSeen;
+  };
+
+  // the map is sorted, so are the nodes
+  std::vector<Node> nodes;
+  nodes.reserve(listElements.size());
+  for (const auto &elem : listElements)
+  {
+    if (!elem.second) continue;
+    const Node node = { elem.second.get(), elem.first, -1, false };
+    nodes.push_back(node);
+  }
+  for (auto &node : nodes)
+  {
+    if (!node.m_element->m_parentId)
+      continue;
+    const int parentId = node.m_element->m_parentId;
+    const auto it = std::lower_bound(nodes.begin(), nodes.end(), parentId,
+                                     [](const Node &n, const int id)
+    {
+      return n.m_id < id;
+    });
+    if (it != nodes.end() && it->m_id == parentId)
+      node.m_parent = int(it - nodes.begin());
+  }
+
+  std::vector<int> path;
+  for (std::size_t i = 0; i < nodes.size(); ++i)
+  {
+    if (nodes[i].m_element->m_listId)
+      continue;
+    int listId = 0;
+    path.clear();
+    int current = int(i);
+    while (current >= 0)
+    {
+      Node &node = nodes[std::size_t(current)];
+      if (node.m_element->m_listId)
+      {
+        listId = node.m_element->m_listId;
+        break;
+      }
+      if (node.m_isSeen)
+      {
+        // oops, this means that we have a loop
+        node.m_element->m_parentId = 0;
+      }
+      else
+        node.m_isSeen = true;
+      if (!node.m_element->m_parentId)
+      {
+        listId = node.m_id;
+        node.m_element->m_listId = listId;
+        break;
+      }
+      path.push_back(current);
+      current = node.m_parent;
+    }
+    for (const int index : path)
+      nodes[std::size_t(index)].m_element->m_listId = listId;
+  }
+}
+
+bool isBlank(const char c)
+{
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isBlank(const char *const begin, const char *const end)
+{
+  return std::all_of(begin, end, [](const char c)
+  {
+    return isBlank(c);
+  });
+}
+
+//! The attributes of the current node of an xmlTextReader.
+class ABWReaderAttributes : public ABWXMLAttributes
+{
+public:
+  explicit ABWReaderAttributes(xmlTextReaderPtr reader)
+    : m_reader(reader)
+    , m_values()
+  {
+  }
+
+  const char *get(const char *const name) override
+  {
+    m_values.push_back(ABWXMLString(xmlTextReaderGetAttribute(m_reader, call_BAD_CAST_OnConst(name))));
+    return m_values.back();
+  }
+
+private:
+  ABWReaderAttributes(const ABWReaderAttributes &);
+  ABWReaderAttributes &operator=(const ABWReaderAttributes &);
+
+  xmlTextReaderPtr m_reader;
+  std::vector<ABWXMLString> m_values;
+};
+
+} // anonymous namespace
+
+/* Decides which blank text nodes are kept, by the rules libxml2's
+   areBlanks() applies to a document it has in one piece: blank text is
+   kept if xml:space is "preserve", if the element has kept text that
+   began with a blank or had a non-ASCII character while xml:space was
+   unspecified, if the first child of the element is text, or if it is
+   the only content of the element. libxml2 itself applies the rules to
+   the pieces of text as its input buffer splits them, so both XML
+   frontends get all the blanks from it and leave the decision to this.
   */
-static int _findAndUpdateListElementId(std::map<int, std::shared_ptr<ABWListElement>> &listElements, int id, std::set<int> &seen)
+class ABWBlankTextFilter
 {
-  if (listElements.find(id)==listElements.end() || !listElements.find(id)->second)
-    return 0;
-  const std::shared_ptr<ABWListElement> &tmpElement= listElements.find(id)->second;
-  if (tmpElement->m_listId)
-    return tmpElement->m_listId;
-  if (seen.find(id)!=seen.end())
+public:
+  struct Element
   {
-    // oops, this means that we have a loop
-    tmpElement->m_parentId=0;
+    //! the xml:space in effect: 1 preserve, 0 default, -1 unspecified
+    int m_space;
+    //! whether text was kept while m_space was -1, which keeps all blanks
+    bool m_keepsBlanks;
+    bool m_hasChildren;
+    bool m_isFirstChildText;
+
+    bool operator==(const Element &other) const;
+  };
+
+  ABWBlankTextFilter();
+
+  void startDocument();
+  //! start a child element, with the value of its xml:space attribute, or nullptr
+  void startElement(const char *space);
+  //! returns the state of the element that ends
+  Element endElement();
+  //! a child other than an element or text
+  void addChild();
+  //! returns whether the text is kept, and adds it to the current element if so
+  bool addText(const char *text, bool blank, bool atEndTag);
+  size_t getDepth() const;
+  //! the state in which the root element last ended
+  const Element &getRootState() const;
+  //! let the root elements of the next documents continue from the state
+  void resumeRoot(const Element &state);
+
+private:
+  std::vector<Element> m_elements;
+  Element m_rootState;
+  bool m_resumesRoot;
+};
+
+bool ABWBlankTextFilter::Element::operator==(const Element &other) const
+{
+  return m_space == other.m_space && m_keepsBlanks == other.m_keepsBlanks && m_hasChildren == other.m_hasChildren
+         && m_isFirstChildText == other.m_isFirstChildText;
+}
+
+ABWBlankTextFilter::ABWBlankTextFilter()
+  : m_elements()
+  , m_rootState { -1, false, false, false }
+  , m_resumesRoot(false)
+{
+}
+
+void ABWBlankTextFilter::startDocument()
+{
+  m_elements.clear();
+}
+
+void ABWBlankTextFilter::startElement(const char *const space)
+{
+  Element element = { -1, false, false, false };
+  if (m_elements.empty())
+  {
+    if (m_resumesRoot)
+      element = m_rootState;
   }
   else
-    seen.insert(id);
-  if (!tmpElement->m_parentId)
   {
-    tmpElement->m_listId=id;
-    return id;
+    addChild();
+    element.m_space = m_elements.back().m_space;
   }
-  tmpElement->m_listId=_findAndUpdateListElementId(listElements, tmpElement->m_parentId, seen);
-  return tmpElement->m_listId;
+  if (space && strcmp(space, "preserve") == 0)
+    element.m_space = 1;
+  else if (space && strcmp(space, "default") == 0)
+    element.m_space = 0;
+  m_elements.push_back(element);
 }
 
-/** try to update the final list id for each list elements */
-static void updateListElementIds(std::map<int, std::shared_ptr<ABWListElement>> &listElements)
+ABWBlankTextFilter::Element ABWBlankTextFilter::endElement()
 {
-  std::set<int> seens;
-  for (const auto &elem : listElements)
+  if (m_elements.empty())
+    return m_rootState;
+  const Element element = m_elements.back();
+  m_elements.pop_back();
+  if (m_elements.empty())
+    m_rootState = element;
+  return element;
+}
+
+void ABWBlankTextFilter::addChild()
+{
+  if (m_elements.empty())
+    return;
+  Element &parent = m_elements.back();
+  if (!parent.m_hasChildren)
+    parent.m_isFirstChildText = false;
+  parent.m_hasChildren = true;
+}
+
+bool ABWBlankTextFilter::addText(const char *const text, const bool blank, const bool atEndTag)
+{
+  // text outside of the root element is not reported
+  if (m_elements.empty())
+    return false;
+  Element &element = m_elements.back();
+  if (blank && !(element.m_space == 1 || element.m_keepsBlanks || element.m_isFirstChildText
+                   || (!element.m_hasChildren && atEndTag)))
+    return false;
+  if (element.m_space == -1 && !element.m_keepsBlanks)
   {
-    if (!elem.second) continue;
-    _findAndUpdateListElementId(listElements, elem.first, seens);
+    element.m_keepsBlanks = isBlank(text[0]) || std::any_of(text, text + strlen(text), [](const char c)
+    {
+      return (c & 0x80) != 0;
+    });
   }
+  if (!element.m_hasChildren)
+    element.m_isFirstChildText = true;
+  element.m_hasChildren = true;
+  return true;
 }
 
-} // anonymous namespace
+size_t ABWBlankTextFilter::getDepth() const
+{
+  return m_elements.size();
+}
+
+const ABWBlankTextFilter::Element &ABWBlankTextFilter::getRootState() const
+{
+  return m_rootState;
+}
+
+void ABWBlankTextFilter::resumeRoot(const Element &state)
+{
+  m_rootState = state;
+  m_resumesRoot = true;
+}
 
 struct ABWParserState
 {
@@ -105,31 +343,819 @@ struct ABWParserState
   std::map<int, int> m_tableSizes;
   std::map<std::string, ABWData> m_data;
   std::map<int, std::shared_ptr<ABWListElement>> m_listElements;
+  ABWListTable m_listTable;
 
   bool m_inMetadata;
   std::string m_currentMetadataKey;
   bool m_inStyleParsing;
-  std::stack<std::unique_ptr<ABWCollector> > m_collectorStack;
+  //! whether the reader is to skip the contents of the current element
+  bool m_isSubtreeSkipped;
+  //! number of frames opened and not yet closed in the content pass
+  int m_frameDepth;
+  //! number of XML nodes read in the current pass
+  unsigned long m_nodeCount;
+  //! whether the XML parser reported an error, from which it recovered or not
+  bool m_hasXmlError;
+  //! number of elements of each token, only used when collecting statistics
+  std::vector<unsigned long> m_elementCounts;
+  ABWBlankTextFilter m_blankTextFilter;
 };
 
 ABWParserState::ABWParserState()
   : m_tableSizes()
   , m_data()
   , m_listElements()
+  , m_listTable()
   , m_inMetadata(false)
   , m_currentMetadataKey()
   , m_inStyleParsing(false)
-  , m_collectorStack()
+  , m_isSubtreeSkipped(false)
+  , m_frameDepth(0)
+  , m_nodeCount(0)
+  , m_hasXmlError(false)
+  , m_elementCounts()
+  , m_blankTextFilter()
 {
 }
 
 ABWParserState::~ABWParserState()
 {
 }
+
+/* Drives an ABWParser from the SAX2 callbacks of libxml2.
+
+   The document is delivered as the xmlTextReader frontend delivers it:
+   adjacent character data form one text node, which goes through the
+   same ABWBlankTextFilter. The contents of <d> are passed on like readD()
+   does, and the elements isElementSkipped() selects are skipped with
+   their contents.
+  */
+class ABWSAXHandler
+{
+public:
+  explicit ABWSAXHandler(ABWParser &parser);
+
+  //! returns false if the document could not be parsed; rethrows what the parser threw
+  bool parse(librevenge::RVNGInputStream *input);
+
+  void startElement(const xmlChar *localName, const xmlChar *prefix, int namespaceCount, const xmlChar **namespaces,
+                    int attributeCount, const xmlChar **attributes);
+  void endElement();
+  void characters(const xmlChar *text, int length);
+  void cdataBlock(const xmlChar *text, int length);
+  //! a comment or a processing instruction
+  void markup();
+  //! store the current exception and stop the parsing
+  void fail();
+
+private:
+  ABWSAXHandler(const ABWSAXHandler &);
+  ABWSAXHandler &operator=(const ABWSAXHandler &);
+
+  void flushText(bool atEndTag);
+
+  ABWParser &m_parser;
+  xmlParserCtxtPtr m_context;
+  //! the tokens of the open elements
+  std::vector<int> m_tokenIds;
+  //! the character data since the last markup
+  std::string m_text;
+  //! the text being flushed; a member, so its buffer is reused
+  std::string m_flushedText;
+  //! the depth of the element being skipped, or 0
+  size_t m_skipLevel;
+  //! the depth of the <d> being read, or 0
+  size_t m_dataLevel;
+  std::unique_ptr<std::string> m_dataName;
+  std::unique_ptr<std::string> m_dataMimeType;
+  bool m_dataBase64;
+  std::exception_ptr m_exception;
+  //! the collector needs nothing more, so the parser was stopped
+  bool m_isFinished;
+};
+
+namespace
+{
+
+//! whether the attribute is called name, which may have a prefix
+bool isQualifiedName(const char *name, const xmlChar *const prefix, const xmlChar *const localName)
+{
+  if (prefix)
+  {
+    const size_t length = strlen(reinterpret_cast<const char *>(prefix));
+    if (strncmp(name, reinterpret_cast<const char *>(prefix), length) != 0 || name[length] != ':')
+      return false;
+    name += length + 1;
+  }
+  return strcmp(name, reinterpret_cast<const char *>(localName)) == 0;
+}
+
+//! The attributes passed to the startElementNs callback.
+class ABWSAXAttributes : public ABWXMLAttributes
+{
+public:
+  ABWSAXAttributes(const xmlChar **attributes, const int count)
+    : m_attributes(attributes)
+    , m_count(count)
+    , m_values()
+  {
+  }
+
+  const char *get(const char *const name) override
+  {
+    for (int i = 0; i < m_count; ++i)
+    {
+      const xmlChar *const *const attribute = m_attributes + 5 * i;
+      if (!isQualifiedName(name, attribute[1], attribute[0]))
+        continue;
+      // like xmlTextReaderGetAttribute(), do not match an undeclared prefix
+      if (!attribute[2] && strchr(name, ':'))
+        continue;
+      // without entity substitution, libxml2 passes '&' as a character reference
+      std::string value(reinterpret_cast<const char *>(attribute[3]), size_t(attribute[4] - attribute[3]));
+      for (size_t pos = value.find("&#38;"); pos != std::string::npos; pos = value.find("&#38;", pos + 1))
+        value.replace(pos, 5, "&");
+      m_values.push_back(value);
+      return m_values.back().c_str();
+    }
+    return nullptr;
+  }
+
+private:
+  ABWSAXAttributes(const ABWSAXAttributes &);
+  ABWSAXAttributes &operator=(const ABWSAXAttributes &);
+
+  const xmlChar **m_attributes;
+  const int m_count;
+  std::deque<std::string> m_values;
+};
+
+extern "C" {
+
+  static void abwSAXStartElement(void *context, const xmlChar *localName, const xmlChar *prefix, const xmlChar *,
+                                 int namespaceCount, const xmlChar **namespaces,
+                                 int attributeCount, int, const xmlChar **attributes)
+  {
+    auto *const handler = static_cast<ABWSAXHandler *>(context);
+    try
+    {
+      handler->startElement(localName, prefix, namespaceCount, namespaces, attributeCount, attributes);
+    }
+    catch (...)
+    {
+      handler->fail();
+    }
+  }
+
+  static void abwSAXEndElement(void *context, const xmlChar *, const xmlChar *, const xmlChar *)
+  {
+    auto *const handler = static_cast<ABWSAXHandler *>(context);
+    try
+    {
+      handler->endElement();
+    }
+    catch (...)
+    {
+      handler->fail();
+    }
+  }
+
+  static void abwSAXCharacters(void *context, const xmlChar *text, int length)
+  {
+    auto *const handler = static_cast<ABWSAXHandler *>(context);
+    try
+    {
+      handler->characters(text, length);
+    }
+    catch (...)
+    {
+      handler->fail();
+    }
+  }
+
+  static void abwSAXCDataBlock(void *context, const xmlChar *text, int length)
+  {
+    auto *const handler = static_cast<ABWSAXHandler *>(context);
+    try
+    {
+      handler->cdataBlock(text, length);
+    }
+    catch (...)
+    {
+      handler->fail();
+    }
+  }
+
+  static void abwSAXComment(void *context, const xmlChar *)
+  {
+    auto *const handler = static_cast<ABWSAXHandler *>(context);
+    try
+    {
+      handler->markup();
+    }
+    catch (...)
+    {
+      handler->fail();
+    }
+  }
+
+  static void abwSAXProcessingInstruction(void *context, const xmlChar *, const xmlChar *)
+  {
+    abwSAXComment(context, nullptr);
+  }
+
+  // libxml2 2.12 made the error passed to structured error handlers const
+#if LIBXML_VERSION >= 21200
+  static void abwSAXError(void *, const xmlError *)
+#else
+  static void abwSAXError(void *, xmlErrorPtr)
+#endif
+  {
+  }
+
+} // extern "C"
+
+} // anonymous namespace
+
+ABWSAXHandler::ABWSAXHandler(ABWParser &parser)
+  : m_parser(parser)
+  , m_context(nullptr)
+  , m_tokenIds()
+  , m_text()
+  , m_flushedText()
+  , m_skipLevel(0)
+  , m_dataLevel(0)
+  , m_dataName()
+  , m_dataMimeType()
+  , m_dataBase64(false)
+  , m_exception()
+  , m_isFinished(false)
+{
+}
+
+bool ABWSAXHandler::parse(librevenge::RVNGInputStream *const input)
+{
+  xmlSAXHandler sax;
+  memset(&sax, 0, sizeof(sax));
+  sax.initialized = XML_SAX2_MAGIC;
+  sax.startElementNs = abwSAXStartElement;
+  sax.endElementNs = abwSAXEndElement;
+  sax.characters = abwSAXCharacters;
+  sax.ignorableWhitespace = abwSAXCharacters;
+  sax.cdataBlock = abwSAXCDataBlock;
+  sax.comment = abwSAXComment;
+  sax.processingInstruction = abwSAXProcessingInstruction;
+  sax.serror = abwSAXError;
+
+  auto context = xmlParserForStream(input, &sax, this);
+  if (!context)
+    return false;
+  m_context = context.get();
+  xmlParseDocument(m_context);
+  m_context = nullptr;
+  if (m_exception)
+    std::rethrow_exception(m_exception);
+  // in the recovery mode, the parsing goes on after errors, but xmlTextReader reports them
+  return m_isFinished || context->wellFormed != 0;
+}
+
+void ABWSAXHandler::startElement(const xmlChar *const localName, const xmlChar *const prefix,
+                                 const int namespaceCount, const xmlChar **const namespaces,
+                                 const int attributeCount, const xmlChar **const attributes)
+{
+  if (m_exception)
+    return;
+  flushText(false);
+
+  ABWBlankTextFilter &filter = m_parser.m_state->m_blankTextFilter;
+  if (m_skipLevel || m_dataLevel)
+  {
+    m_tokenIds.push_back(XML_TOKEN_INVALID);
+    filter.startElement(nullptr);
+    return;
+  }
+
+  int tokenId = XML_TOKEN_INVALID;
+  if (prefix)
+  {
+    std::string name(reinterpret_cast<const char *>(prefix));
+    name += ':';
+    name += reinterpret_cast<const char *>(localName);
+    tokenId = ABWXMLTokenMap::getTokenId(reinterpret_cast<const xmlChar *>(name.c_str()));
+  }
+  else
+    tokenId = ABWXMLTokenMap::getTokenId(localName);
+
+  m_parser.countNode(filter.getDepth());
+  if (m_parser.m_statistics && m_parser.m_state->m_inStyleParsing)
+  {
+    // like xmlTextReaderMoveToNextAttribute(), count the namespace declarations too
+    unsigned long attributeBytes = 0;
+    for (int i = 0; i < namespaceCount; ++i)
+    {
+      if (namespaces[2 * i + 1])
+        attributeBytes += (unsigned long) xmlStrlen(namespaces[2 * i + 1]);
+    }
+    for (int i = 0; i < attributeCount; ++i)
+      attributeBytes += (unsigned long)(attributes[5 * i + 4] - attributes[5 * i + 3]);
+    m_parser.collectElementStatistics(tokenId, attributeBytes);
+  }
+  ABWSAXAttributes elementAttributes(attributes, attributeCount);
+  filter.startElement(elementAttributes.get("xml:space"));
+  m_tokenIds.push_back(tokenId);
+
+  if (m_parser.isElementSkipped(tokenId))
+  {
+    m_skipLevel = m_tokenIds.size();
+    return;
+  }
+
+  switch (tokenId)
+  {
+  case XML_D:
+  {
+    m_dataLevel = m_tokenIds.size();
+    const char *const name = elementAttributes.get("name");
+    m_dataName.reset(name ? new std::string(name) : nullptr);
+    const char *const mimeType = elementAttributes.get("mime-type");
+    m_dataMimeType.reset(mimeType ? new std::string(mimeType) : nullptr);
+    const char *const base64 = elementAttributes.get("base64");
+    m_dataBase64 = false;
+    if (base64)
+      findBool(base64, m_dataBase64);
+    break;
+  }
+  default:
+    m_parser.startElement(tokenId, elementAttributes);
+    if (m_parser.m_collector->isFinished())
+    {
+      m_isFinished = true;
+      xmlStopParser(m_context);
+    }
+    break;
+  }
+}
+
+void ABWSAXHandler::endElement()
+{
+  if (m_exception || m_tokenIds.empty())
+    return;
+  flushText(true);
+
+  const int tokenId = m_tokenIds.back();
+  m_tokenIds.pop_back();
+  const ABWBlankTextFilter::Element element = m_parser.m_state->m_blankTextFilter.endElement();
+  if (m_skipLevel || m_dataLevel)
+  {
+    if (m_tokenIds.size() + 1 == m_skipLevel)
+      m_skipLevel = 0;
+    if (m_tokenIds.size() + 1 == m_dataLevel)
+      m_dataLevel = 0;
+    return;
+  }
+
+  // an element without children is reported once by xmlTextReader
+  if (element.m_hasChildren)
+    m_parser.countNode(m_tokenIds.size());
+  m_parser.endElement(tokenId);
+}
+
+void ABWSAXHandler::characters(const xmlChar *const text, const int length)
+{
+  if (m_exception || m_skipLevel || length <= 0)
+    return;
+  m_text.append(reinterpret_cast<const char *>(text), size_t(length));
+}
+
+void ABWSAXHandler::cdataBlock(const xmlChar *const text, const int length)
+{
+  if (m_exception || m_skipLevel)
+    return;
+  flushText(false);
+  if (m_dataLevel)
+  {
+    const std::string data(reinterpret_cast<const char *>(text), size_t(std::max(length, 0)));
+    m_parser.readData(m_dataName ? m_dataName->c_str() : nullptr, m_dataMimeType ? m_dataMimeType->c_str() : nullptr,
+                      m_dataBase64, data.c_str(), (unsigned long) data.size());
+    return;
+  }
+  markup();
+}
+
+void ABWSAXHandler::markup()
+{
+  if (m_exception || m_skipLevel)
+    return;
+  flushText(false);
+  if (m_dataLevel)
+    return;
+  ABWBlankTextFilter &filter = m_parser.m_state->m_blankTextFilter;
+  filter.addChild();
+  m_parser.countNode(filter.getDepth());
+}
+
+void ABWSAXHandler::fail()
+{
+  if (!m_exception)
+    m_exception = std::current_exception();
+  if (m_context)
+    xmlStopParser(m_context);
+}
+
+void ABWSAXHandler::flushText(const bool atEndTag)
+{
+  if (m_text.empty())
+    return;
+  m_flushedText.swap(m_text);
+  m_text.clear();
+  const std::string &text = m_flushedText;
+  const bool blank = isBlank(text.data(), text.data() + text.size());
+
+  if (m_dataLevel)
+  {
+    if (!blank)
+      m_parser.readData(m_dataName ? m_dataName->c_str() : nullptr, m_dataMimeType ? m_dataMimeType->c_str() : nullptr,
+                        m_dataBase64, text.c_str(), (unsigned long) text.size());
+    return;
+  }
+  m_parser.readTextNode(text.c_str(), blank, atEndTag);
+}
+
+namespace
+{
+
+//! the smallest part of the content that is worth parsing on another thread
+const unsigned long MIN_CONTENT_PART_SIZE = 256 * 1024;
+
+/* Splits the content at the ends of top-level sections, into parts of
+   at least MIN_CONTENT_PART_SIZE bytes, a few for each thread. Returns
+   the indices of the elements that begin the parts after the first.
+  */
+std::vector<size_t> splitContent(const ABWDocumentLayout &layout, const unsigned long size, const unsigned threads)
+{
+  std::vector<size_t> starts;
+  if (layout.m_elements.empty())
+    return starts;
+  const unsigned long contentSize = size - layout.m_elements.front().m_begin;
+  const unsigned long partSize = std::max(MIN_CONTENT_PART_SIZE, contentSize / (4 * threads));
+  unsigned long partBegin = layout.m_elements.front().m_begin;
+  for (size_t i = 0; i + 1 < layout.m_elements.size(); ++i)
+  {
+    const ABWTopLevelElement &element = layout.m_elements[i];
+    if (element.m_isSection && element.m_end - partBegin >= partSize)
+    {
+      starts.push_back(i + 1);
+      partBegin = element.m_end;
+    }
+  }
+  if (!starts.empty() && size - partBegin < MIN_CONTENT_PART_SIZE)
+    starts.pop_back();
+  return starts;
+}
+
+} // anonymous namespace
+
+/* Parses the parts of the content after the first on other threads.
+
+   A part is made of top-level sections and the elements between them,
+   wrapped in the prolog and the root element of the document. Each part
+   gets its own parser and content collector, which first parse a
+   skeleton of what precedes the part: the top-level elements other than
+   sections, and the sections without their contents; the elements the
+   content pass skips, like <data>, are emptied as well. That brings them
+   to the state in which the sequential parsing enters the part, as far
+   as the state is carried from section to section; the state is
+   compared when the part is appended, and a part that was entered in
+   another state is parsed again, on the calling thread.
+
+   The parts count their nodes and output elements into a shared budget,
+   so that they buffer no more than the limits allow together. A part
+   that exceeds a limit stops the workers; the calling thread parses the
+   parts that are left itself, and finds where the limit is exceeded.
+  */
+class ABWContentWorkers
+{
+public:
+  ABWContentWorkers(ABWParser &parser, const unsigned char *data, unsigned long size, const ABWDocumentLayout &layout,
+                    const std::vector<size_t> &starts);
+  ~ABWContentWorkers();
+
+  //! start up to count threads; returns false if none could be started
+  bool start(unsigned count);
+  //! parse the content into the collector of the parser
+  bool parse();
+
+private:
+  ABWContentWorkers(const ABWContentWorkers &);
+  ABWContentWorkers &operator=(const ABWContentWorkers &);
+
+  struct Part
+  {
+    Part();
+
+    std::unique_ptr<ABWParseControl> m_control;
+    std::unique_ptr<ABWParser> m_parser;
+    ABWContentSectionState m_entryState;
+    ABWBlankTextFilter::Element m_rootState;
+    bool m_inMetadata;
+    std::string m_currentMetadataKey;
+    int m_frameDepth;
+    unsigned long m_nodeCount;
+    bool m_isParsed;
+    bool m_isDone;
+  };
+
+  void run();
+  void parsePart(Part &part, size_t index);
+
+  //! the offset of the part in the document
+  unsigned long getPartBegin(size_t index) const;
+  unsigned long getPartEnd(size_t index) const;
+  void appendRootStartTag(std::string &document) const;
+  void makePartDocument(size_t index, std::string &document) const;
+  /** the document before the part, with the sections and the elements the content pass skips emptied;
+      returns the number of tables in those sections
+    */
+  int makeSkeletonDocument(size_t index, std::string &document) const;
+
+  ABWParser &m_parser;
+  const unsigned char *const m_data;
+  const unsigned long m_size;
+  const ABWDocumentLayout &m_layout;
+  //! the indices of the top-level elements that begin the parts after the first
+  const std::vector<size_t> &m_starts;
+  std::vector<std::unique_ptr<Part>> m_parts;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  //! the next part to be parsed by a worker
+  size_t m_next;
+  //! the cancellation flag of the workers
+  std::atomic<bool> m_stop;
+  ABWSharedBudget m_budget;
+  std::vector<std::thread> m_threads;
+};
+
+ABWContentWorkers::Part::Part()
+  : m_control()
+  , m_parser()
+  , m_entryState()
+  , m_rootState()
+  , m_inMetadata(false)
+  , m_currentMetadataKey()
+  , m_frameDepth(0)
+  , m_nodeCount(0)
+  , m_isParsed(false)
+  , m_isDone(false)
+{
+}
+
+ABWContentWorkers::ABWContentWorkers(ABWParser &parser, const unsigned char *const data, const unsigned long size,
+                                     const ABWDocumentLayout &layout, const std::vector<size_t> &starts)
+  : m_parser(parser)
+  , m_data(data)
+  , m_size(size)
+  , m_layout(layout)
+  , m_starts(starts)
+  , m_parts()
+  , m_mutex()
+  , m_condition()
+  , m_next(1)
+  , m_stop(false)
+  , m_budget()
+  , m_threads()
+{
+  for (size_t i = 0; i <= starts.size(); ++i)
+    m_parts.push_back(std::unique_ptr<Part>(new Part()));
+}
+
+ABWContentWorkers::~ABWContentWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  for (auto &thread : m_threads)
+    thread.join();
+}
+
+bool ABWContentWorkers::start(const unsigned count)
+{
+  for (unsigned i = 0; i < count && i < m_starts.size(); ++i)
+  {
+    try
+    {
+      m_threads.push_back(std::thread(&ABWContentWorkers::run, this));
+    }
+    catch (const std::system_error &)
+    {
+      ABW_DEBUG_MSG(("ABWContentWorkers: cannot start a thread\n"));
+      break;
+    }
+  }
+  return !m_threads.empty();
+}
+
+unsigned long ABWContentWorkers::getPartBegin(const size_t index) const
+{
+  return index == 0 ? 0 : m_layout.m_elements[m_starts[index - 1] - 1].m_end;
+}
+
+unsigned long ABWContentWorkers::getPartEnd(const size_t index) const
+{
+  return index == m_starts.size() ? m_size : m_layout.m_elements[m_starts[index] - 1].m_end;
+}
+
+void ABWContentWorkers::appendRootStartTag(std::string &document) const
+{
+  document.append(reinterpret_cast<const char *>(m_data), m_layout.m_rootBegin);
+  document += m_layout.m_rootStartTag;
+  document += '>';
+}
+
+void ABWContentWorkers::makePartDocument(const size_t index, std::string &document) const
+{
+  const unsigned long begin = getPartBegin(index);
+  const unsigned long end = getPartEnd(index);
+  document.clear();
+  if (index != 0)
+    appendRootStartTag(document);
+  document.append(reinterpret_cast<const char *>(m_data) + begin, end - begin);
+  if (index != m_starts.size())
+    document += m_layout.m_rootEndTag;
+}
+
+int ABWContentWorkers::makeSkeletonDocument(const size_t index, std::string &document) const
+{
+  int tableCount = 0;
+  unsigned long end = 0;
+  document.clear();
+  for (size_t i = 0; i < m_starts[index - 1]; ++i)
+  {
+    const ABWTopLevelElement &element = m_layout.m_elements[i];
+    document.append(reinterpret_cast<const char *>(m_data) + end, element.m_begin - end);
+    if (element.m_isSection)
+    {
+      document.append(reinterpret_cast<const char *>(m_data) + element.m_begin, element.m_startTagEnd - element.m_begin);
+      if (element.m_hasChildElements)
+        document += "<p/>";
+      if (element.m_startTagEnd != element.m_end)
+        document += "</section>";
+      tableCount += element.m_tableCount;
+    }
+    else if (m_parser.isElementSkipped(element.m_tokenId) && element.m_startTagEnd != element.m_end)
+    {
+      // e.g., <data> or <history>, which can be most of the document
+      document.append(reinterpret_cast<const char *>(m_data) + element.m_begin, element.m_startTagEnd - element.m_begin - 1);
+      document += "/>";
+    }
+    else
+      document.append(reinterpret_cast<const char *>(m_data) + element.m_begin, element.m_end - element.m_begin);
+    end = element.m_end;
+  }
+  document += m_layout.m_rootEndTag;
+  return tableCount;
+}
+
+void ABWContentWorkers::run()
+{
+  while (true)
+  {
+    size_t index = 0;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_stop || m_next == m_parts.size())
+        return;
+      index = m_next++;
+    }
+    Part &part = *m_parts[index];
+    parsePart(part, index);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      part.m_isDone = true;
+    }
+    m_condition.notify_all();
+  }
+}
+
+void ABWContentWorkers::parsePart(Part &part, const size_t index) try
+{
+  AbiParseOptions options;
+  options.m_cancel = &m_stop;
+  part.m_control.reset(new ABWParseControl(options));
+  if (m_parser.m_control)
+    part.m_control->copySettings(*m_parser.m_control);
+  part.m_parser.reset(new ABWParser(nullptr, nullptr, nullptr, part.m_control.get(), m_parser.m_frontend));
+  ABWParser &parser = *part.m_parser;
+  const ABWParserState &state = *m_parser.m_state;
+  ABWContentCollector *const collector
+    = new ABWContentCollector(nullptr, state.m_tableSizes, state.m_data, state.m_listTable, nullptr, part.m_control.get());
+  parser.m_collector.reset(collector);
+
+  std::string document;
+  const int tableCount = makeSkeletonDocument(index, document);
+  {
+    ABWMemoryStream input(reinterpret_cast<const unsigned char *>(document.data()), document.size());
+    if (!parser.parseXmlDocument(&input) || parser.m_state->m_hasXmlError || !collector->isBetweenSections())
+      return;
+  }
+  collector->skipTables(tableCount);
+  collector->saveSectionState(part.m_entryState);
+  part.m_rootState = parser.m_state->m_blankTextFilter.getRootState();
+  parser.m_state->m_blankTextFilter.resumeRoot(part.m_rootState);
+  part.m_inMetadata = parser.m_state->m_inMetadata;
+  part.m_currentMetadataKey = parser.m_state->m_currentMetadataKey;
+  part.m_frameDepth = parser.m_state->m_frameDepth;
+  collector->clearOutput();
+  parser.m_state->m_nodeCount = 0;
+  part.m_control->shareBudget(&m_budget);
+
+  makePartDocument(index, document);
+  ABWMemoryStream input(reinterpret_cast<const unsigned char *>(document.data()), document.size());
+  part.m_isParsed = parser.parseXmlDocument(&input) && !parser.m_state->m_hasXmlError;
+  part.m_nodeCount = parser.m_state->m_nodeCount;
+}
+catch (const ABWLimitExceededException &)
+{
+  part.m_isParsed = false;
+  m_stop = true;
+}
+catch (...)
+{
+  part.m_isParsed = false;
+}
+
+bool ABWContentWorkers::parse()
+{
+  ABWParserState &state = *m_parser.m_state;
+  ABWContentCollector &collector = static_cast<ABWContentCollector &>(*m_parser.m_collector);
+  std::string document;
+  makePartDocument(0, document);
+  {
+    ABWMemoryStream input(reinterpret_cast<const unsigned char *>(document.data()), document.size());
+    if (!m_parser.parseXmlDocument(&input))
+      return false;
+  }
+  state.m_blankTextFilter.resumeRoot(state.m_blankTextFilter.getRootState());
+
+  for (size_t index = 1; index < m_parts.size(); ++index)
+  {
+    Part &part = *m_parts[index];
+    bool isStarted = true;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      // a part that no worker has started is parsed here
+      if (index >= m_next)
+      {
+        m_next = index + 1;
+        isStarted = false;
+      }
+      while (isStarted && !part.m_isDone)
+      {
+        // the workers only see the cancellation by m_stop
+        m_condition.wait_for(lock, std::chrono::milliseconds(50));
+        if (m_parser.m_control)
+          m_parser.m_control->checkCancelled();
+      }
+    }
+
+    if (part.m_isParsed && state.m_blankTextFilter.getRootState() == part.m_rootState
+        && state.m_inMetadata == part.m_inMetadata
+        && state.m_currentMetadataKey == part.m_currentMetadataKey && state.m_frameDepth == part.m_frameDepth
+        && collector.canAppendSections(part.m_entryState, static_cast<ABWContentCollector &>(*part.m_parser->m_collector)))
+    {
+      collector.appendSections(static_cast<ABWContentCollector &>(*part.m_parser->m_collector));
+      const ABWParserState &partState = *part.m_parser->m_state;
+      state.m_inMetadata = partState.m_inMetadata;
+      state.m_currentMetadataKey = partState.m_currentMetadataKey;
+      state.m_frameDepth = partState.m_frameDepth;
+      state.m_blankTextFilter.resumeRoot(partState.m_blankTextFilter.getRootState());
+      state.m_nodeCount += part.m_nodeCount;
+      if (m_parser.m_control)
+        m_parser.m_control->checkNodeCount(state.m_nodeCount);
+    }
+    else
+    {
+      if (m_parser.m_statistics && isStarted)
+        ++m_parser.m_statistics->m_reparsedContentPartCount;
+      makePartDocument(index, document);
+      ABWMemoryStream input(reinterpret_cast<const unsigned char *>(document.data()), document.size());
+      if (!m_parser.parseXmlDocument(&input))
+        return false;
+    }
+    part.m_parser.reset();
+    part.m_control.reset();
+  }
+  return true;
+}
+
 } // namespace libabw
 
-libabw::ABWParser::ABWParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *iface)
-  : m_input(input), m_iface(iface), m_collector(), m_state(new ABWParserState())
+libabw::ABWParser::ABWParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *iface,
+                             AbiParseStatistics *statistics, ABWParseControl *control, ABWXMLFrontend frontend,
+                             unsigned contentThreads, unsigned dataThreads)
+  : m_input(input), m_iface(iface), m_statistics(statistics), m_control(control), m_frontend(frontend)
+  , m_contentThreads(contentThreads), m_dataThreads(dataThreads), m_collector(), m_dataDecoder()
+  , m_state(new ABWParserState())
 {
 }
 
@@ -147,13 +1173,73 @@ bool libabw::ABWParser::parse()
     m_collector.reset(new ABWStylesCollector(m_state->m_tableSizes, m_state->m_data, m_state->m_listElements));
     m_input->seek(0, librevenge::RVNG_SEEK_SET);
     m_state->m_inStyleParsing=true;
+    if (m_statistics)
+      m_state->m_elementCounts.assign(XML_TOKEN_COUNT + 1, 0);
+    if (m_dataThreads)
+      m_dataDecoder.reset(new ABWDataDecoder(m_dataThreads));
     if (!processXmlDocument(m_input))
       return false;
+    if (m_dataDecoder)
+    {
+      // the content pass needs the images
+      ABWPhaseTimer timer(m_statistics, AbiParseStatistics::PHASE_STYLES);
+      m_dataDecoder->finish(*m_collector, m_statistics, m_control);
+      m_dataDecoder.reset();
+    }
+    if (m_statistics)
+    {
+      for (int tokenId = 1; tokenId <= XML_TOKEN_COUNT; ++tokenId)
+      {
+        const char *const name = ABWXMLTokenMap::getTokenName(tokenId);
+        if (name && m_state->m_elementCounts[size_t(tokenId)])
+        {
+          const librevenge::RVNGProperty *const total = m_statistics->m_elementCounts[name];
+          const int count = int(m_state->m_elementCounts[size_t(tokenId)]);
+          m_statistics->m_elementCounts.insert(name, total ? total->getInt() + count : count);
+        }
+      }
+    }
     updateListElementIds(m_state->m_listElements);
-    m_collector.reset(new ABWContentCollector(m_iface, m_state->m_tableSizes, m_state->m_data, m_state->m_listElements));
+    m_state->m_listTable.build(m_state->m_listElements);
+    m_collector.reset(new ABWContentCollector(m_iface, m_state->m_tableSizes, m_state->m_data, m_state->m_listTable,
+                                              m_statistics, m_control));
+    m_input->seek(0, librevenge::RVNG_SEEK_SET);
+    m_state->m_inStyleParsing=false;
+    m_state->m_nodeCount = 0;
+    return processContent() && m_state->m_frameDepth==0;
+  }
+  catch (const ABWCancelledException &)
+  {
+    throw;
+  }
+  catch (const ABWLimitExceededException &)
+  {
+    throw;
+  }
+  catch (...)
+  {
+  }
+  return false;
+}
+
+bool libabw::ABWParser::parseMetadata(ABWPropertyMap &metadata)
+{
+  if (!m_input)
+    return false;
+
+  try
+  {
+    m_collector.reset(new ABWMetadataCollector(metadata));
     m_input->seek(0, librevenge::RVNG_SEEK_SET);
-    m_state->m_inStyleParsing=false;
-    return processXmlDocument(m_input) && m_state->m_collectorStack.empty();
+    return parseXmlDocument(m_input);
+  }
+  catch (const ABWCancelledException &)
+  {
+    throw;
+  }
+  catch (const ABWLimitExceededException &)
+  {
+    throw;
   }
   catch (...)
   {
@@ -162,361 +1248,497 @@ bool libabw::ABWParser::parse()
 }
 
 bool libabw::ABWParser::processXmlDocument(librevenge::RVNGInputStream *input)
+{
+  ABWPhaseTimer timer(m_statistics, m_state->m_inStyleParsing ? AbiParseStatistics::PHASE_STYLES : AbiParseStatistics::PHASE_CONTENT);
+  const bool isParsed = parseXmlDocument(input);
+  timer.stop();
+
+  if (m_collector)
+    m_collector->endDocument();
+  return isParsed;
+}
+
+bool libabw::ABWParser::processContent()
+{
+  unsigned long size = 0;
+  // the layout can only be trusted if the document is well-formed
+  const unsigned char *const data = m_contentThreads > 1 && !m_state->m_hasXmlError ? getStreamData(m_input, size) : nullptr;
+  ABWDocumentLayout layout;
+  if (!data || !findDocumentLayout(data, size, layout))
+    return processXmlDocument(m_input);
+  const std::vector<size_t> starts = splitContent(layout, size, m_contentThreads);
+  if (starts.empty())
+    return processXmlDocument(m_input);
+
+  ABWPhaseTimer timer(m_statistics, AbiParseStatistics::PHASE_CONTENT);
+  bool isParsed = false;
+  {
+    ABWContentWorkers workers(*this, data, size, layout, starts);
+    if (!workers.start(m_contentThreads - 1))
+    {
+      timer.stop();
+      return processXmlDocument(m_input);
+    }
+    isParsed = workers.parse();
+  }
+  timer.stop();
+  if (m_statistics)
+    m_statistics->m_contentPartCount += starts.size() + 1;
+
+  m_collector->endDocument();
+  return isParsed;
+}
+
+bool libabw::ABWParser::parseXmlDocument(librevenge::RVNGInputStream *input)
 {
   if (!input)
     return false;
+  m_state->m_blankTextFilter.startDocument();
+  if (m_frontend == ABW_XML_SAX)
+    return parseXmlDocumentSAX(input);
 
   ABWXMLProgressWatcher watcher;
   auto reader(xmlReaderForStream(input, &watcher));
   if (!reader)
     return false;
+  // whether blank text is kept can depend on the node after it
+  std::string blankText;
+  bool hasBlankText = false;
   int ret = xmlTextReaderRead(reader.get());
   while (1 == ret && !watcher.isStuck())
   {
+    const int tokenType = xmlTextReaderNodeType(reader.get());
+    if (hasBlankText)
+    {
+      hasBlankText = false;
+      readTextNode(blankText.c_str(), true, XML_READER_TYPE_END_ELEMENT == tokenType);
+    }
+    if (XML_READER_TYPE_WHITESPACE == tokenType || XML_READER_TYPE_SIGNIFICANT_WHITESPACE == tokenType)
+    {
+      blankText = (const char *)xmlTextReaderConstValue(reader.get());
+      hasBlankText = true;
+      ret = xmlTextReaderRead(reader.get());
+      continue;
+    }
+    if (XML_READER_TYPE_TEXT == tokenType)
+    {
+      readTextNode((const char *)xmlTextReaderConstValue(reader.get()), false, false);
+      ret = xmlTextReaderRead(reader.get());
+      continue;
+    }
+    if (m_control)
+    {
+      m_control->checkCancelled();
+      m_control->checkNodeCount(++m_state->m_nodeCount);
+      m_control->checkDepth(static_cast<unsigned long>(xmlTextReaderDepth(reader.get())));
+    }
     ret = processXmlNode(reader.get());
     if (ret == 1)
-      ret = xmlTextReaderRead(reader.get());
+      ret = m_state->m_isSubtreeSkipped ? xmlTextReaderNext(reader.get()) : xmlTextReaderRead(reader.get());
+    m_state->m_isSubtreeSkipped = false;
+    if (1 == ret && m_collector->isFinished())
+      ret = 0;
   }
-
-  if (m_collector)
-    m_collector->endDocument();
+  // the input may have failed for a reason that must not be reported as a parse error
+  if (m_control)
+    m_control->checkCancelled();
+  if (ret != 0 || watcher.hasError())
+    m_state->m_hasXmlError = true;
   return ret == 0 && !watcher.isStuck();
 }
 
+bool libabw::ABWParser::parseXmlDocumentSAX(librevenge::RVNGInputStream *input)
+{
+  ABWSAXHandler handler(*this);
+  const bool isParsed = handler.parse(input);
+  // the input may have failed for a reason that must not be reported as a parse error
+  if (m_control)
+    m_control->checkCancelled();
+  if (!isParsed)
+    m_state->m_hasXmlError = true;
+  return isParsed;
+}
+
 int libabw::ABWParser::processXmlNode(xmlTextReaderPtr reader)
 {
   if (!reader)
     return -1;
-  int tokenId = getElementToken(reader);
   int tokenType = xmlTextReaderNodeType(reader);
+  // only elements need the token
+  int tokenId = XML_READER_TYPE_ELEMENT == tokenType || XML_READER_TYPE_END_ELEMENT == tokenType
+                ? getElementToken(reader) : XML_TOKEN_INVALID;
   int emptyToken = xmlTextReaderIsEmptyElement(reader);
-  if (XML_READER_TYPE_SIGNIFICANT_WHITESPACE == tokenType)
-  {
-    const auto *text = (const char *)xmlTextReaderConstValue(reader);
-    if (!m_state->m_inMetadata && text && text[0]==' ' && text[1]==0)
-      m_collector->insertText(text);
-    return 1;
-  }
-  else if (XML_READER_TYPE_TEXT == tokenType)
+  if (m_statistics && m_state->m_inStyleParsing)
+    collectNodeStatistics(reader, tokenId, tokenType);
+  ABWBlankTextFilter &filter = m_state->m_blankTextFilter;
+
+  int ret = 1;
+
+  if (XML_READER_TYPE_ELEMENT == tokenType)
   {
-    const auto *text = (const char *)xmlTextReaderConstValue(reader);
-    ABW_DEBUG_MSG(("ABWParser::processXmlNode: text %s\n", text));
-    if (m_state->m_inMetadata)
+    if (isElementSkipped(tokenId))
     {
-      if (m_state->m_currentMetadataKey.empty())
-      {
-        ABW_DEBUG_MSG(("there is no key for metadata entry '%s'\n", text));
-      }
-      else
+      filter.addChild();
+      m_state->m_isSubtreeSkipped = true;
+    }
+    else if (XML_D == tokenId)
+    {
+      filter.addChild();
+      ret = readD(reader);
+    }
+    else
+    {
+      ABWReaderAttributes attributes(reader);
+      filter.startElement(attributes.get("xml:space"));
+      startElement(tokenId, attributes);
+      if (emptyToken > 0)
       {
-        m_collector->addMetadataEntry(m_state->m_currentMetadataKey.c_str(), text);
-        m_state->m_currentMetadataKey.clear();
+        filter.endElement();
+        endElement(tokenId);
       }
     }
-    else
+  }
+  else if (XML_READER_TYPE_END_ELEMENT == tokenType)
+  {
+    filter.endElement();
+    endElement(tokenId);
+  }
+  else if (XML_READER_TYPE_CDATA == tokenType || XML_READER_TYPE_COMMENT == tokenType
+           || XML_READER_TYPE_PROCESSING_INSTRUCTION == tokenType)
+    filter.addChild();
+
+#ifdef DEBUG
+  const xmlChar *name = xmlTextReaderConstName(reader);
+  const xmlChar *value = xmlTextReaderConstValue(reader);
+  int isEmptyElement = xmlTextReaderIsEmptyElement(reader);
+
+  ABW_DEBUG_MSG(("%i %i %s", isEmptyElement, tokenType, name ? (const char *)name : ""));
+  if (xmlTextReaderNodeType(reader) == 1)
+  {
+    while (xmlTextReaderMoveToNextAttribute(reader))
     {
-      m_collector->insertText(text);
+      const xmlChar *name1 = xmlTextReaderConstName(reader);
+      const xmlChar *value1 = xmlTextReaderConstValue(reader);
+      ABW_DEBUG_MSG((" %s=\"%s\"", name1, value1));
     }
   }
 
-  int ret = 1;
+  if (!value)
+    ABW_DEBUG_MSG(("\n"));
+  else
+  {
+    ABW_DEBUG_MSG((" %s\n", value));
+  }
+#endif
+
+  return ret;
+}
+
+int libabw::ABWParser::getElementToken(xmlTextReaderPtr reader)
+{
+  return ABWXMLTokenMap::getTokenId(xmlTextReaderConstName(reader));
+}
+
+void libabw::ABWParser::collectNodeStatistics(xmlTextReaderPtr reader, int tokenId, int tokenType)
+{
+  ++m_statistics->m_nodeCount;
+  if (XML_READER_TYPE_ELEMENT != tokenType)
+    return;
+  unsigned long attributeBytes = 0;
+  if (xmlTextReaderMoveToFirstAttribute(reader) == 1)
+  {
+    do
+    {
+      const xmlChar *value = xmlTextReaderConstValue(reader);
+      if (value)
+        attributeBytes += (unsigned long) xmlStrlen(value);
+    }
+    while (xmlTextReaderMoveToNextAttribute(reader) == 1);
+    xmlTextReaderMoveToElement(reader);
+  }
+  collectElementStatistics(tokenId, attributeBytes);
+}
+
+void libabw::ABWParser::collectElementStatistics(const int tokenId, const unsigned long attributeBytes)
+{
+  if (tokenId > 0 && size_t(tokenId) < m_state->m_elementCounts.size())
+    ++m_state->m_elementCounts[size_t(tokenId)];
+  else
+    ++m_statistics->m_unknownElementCount;
+  m_statistics->m_attributeBytes += attributeBytes;
+}
 
+bool libabw::ABWParser::isElementSkipped(const int tokenId) const
+{
+  switch (tokenId)
+  {
+  case XML_HISTORY:
+  case XML_REVISIONS:
+  case XML_IGNOREDWORDS:
+    return true;
+  default:
+    return m_collector && m_collector->isElementIgnored(tokenId);
+  }
+}
+
+void libabw::ABWParser::startElement(const int tokenId, ABWXMLAttributes &attributes)
+{
   switch (tokenId)
   {
   case XML_ABIWORD:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readAbiword(reader);
+    readAbiword(attributes);
     break;
   case XML_METADATA:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      m_state->m_inMetadata = true;
-    if ((XML_READER_TYPE_END_ELEMENT == tokenType) || (emptyToken > 0))
-      m_state->m_inMetadata = false;
+    m_state->m_inMetadata = true;
     break;
   case XML_M:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readM(reader);
-    break;
-  case XML_HISTORY:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      ret = readHistory(reader);
-    break;
-  case XML_REVISIONS:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      ret = readRevisions(reader);
-    break;
-  case XML_IGNOREDWORDS:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      ret = readIgnoredWords(reader);
+    readM(attributes);
     break;
   case XML_S:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readS(reader);
+    readS(attributes);
     break;
   case XML_L:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readL(reader);
+    readL(attributes);
     break;
   case XML_PAGESIZE:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readPageSize(reader);
+    readPageSize(attributes);
     break;
   case XML_SECTION:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readSection(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      if (m_collector)
-        m_collector->endSection();
-    break;
-  case XML_D:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      ret = readD(reader);
+    readSection(attributes);
     break;
   case XML_P:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readP(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      if (m_collector)
-        m_collector->closeParagraphOrListElement();
+    readP(attributes);
     break;
   case XML_C:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readC(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      if (m_collector)
-        m_collector->closeSpan();
+    readC(attributes);
     break;
   case XML_CBR:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      m_collector->insertColumnBreak();
+    m_collector->insertColumnBreak();
     break;
   case XML_PBR:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      m_collector->insertPageBreak();
+    m_collector->insertPageBreak();
     break;
   case XML_BR:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      m_collector->insertLineBreak();
+    m_collector->insertLineBreak();
     break;
   case XML_A:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readA(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      m_collector->closeLink();
+    readA(attributes);
     break;
   case XML_FOOT:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readFoot(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      m_collector->closeFoot();
+    readFoot(attributes);
     break;
   case XML_ENDNOTE:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readEndnote(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      m_collector->closeEndnote();
+    readEndnote(attributes);
     break;
   case XML_FIELD:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readField(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      m_collector->closeField();
+    readField(attributes);
     break;
   case XML_TABLE:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readTable(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      m_collector->closeTable();
+    readTable(attributes);
     break;
   case XML_CELL:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readCell(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      m_collector->closeCell();
+    readCell(attributes);
     break;
   case XML_IMAGE:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readImage(reader);
+    readImage(attributes);
     break;
   case XML_FRAME:
-    if (XML_READER_TYPE_ELEMENT == tokenType)
-      readFrame(reader);
-    if (XML_READER_TYPE_END_ELEMENT == tokenType || emptyToken > 0)
-      readCloseFrame();
+    readFrame(attributes);
     break;
   default:
     break;
   }
-
-#ifdef DEBUG
-  const xmlChar *name = xmlTextReaderConstName(reader);
-  const xmlChar *value = xmlTextReaderConstValue(reader);
-  int isEmptyElement = xmlTextReaderIsEmptyElement(reader);
-
-  ABW_DEBUG_MSG(("%i %i %s", isEmptyElement, tokenType, name ? (const char *)name : ""));
-  if (xmlTextReaderNodeType(reader) == 1)
-  {
-    while (xmlTextReaderMoveToNextAttribute(reader))
-    {
-      const xmlChar *name1 = xmlTextReaderConstName(reader);
-      const xmlChar *value1 = xmlTextReaderConstValue(reader);
-      ABW_DEBUG_MSG((" %s=\"%s\"", name1, value1));
-    }
-  }
-
-  if (!value)
-    ABW_DEBUG_MSG(("\n"));
-  else
-  {
-    ABW_DEBUG_MSG((" %s\n", value));
-  }
-#endif
-
-  return ret;
 }
 
-int libabw::ABWParser::getElementToken(xmlTextReaderPtr reader)
+void libabw::ABWParser::endElement(const int tokenId)
 {
-  return ABWXMLTokenMap::getTokenId(xmlTextReaderConstName(reader));
+  switch (tokenId)
+  {
+  case XML_METADATA:
+    m_state->m_inMetadata = false;
+    break;
+  case XML_SECTION:
+    if (m_collector)
+      m_collector->endSection();
+    break;
+  case XML_P:
+    if (m_collector)
+      m_collector->closeParagraphOrListElement();
+    break;
+  case XML_C:
+    if (m_collector)
+      m_collector->closeSpan();
+    break;
+  case XML_A:
+    m_collector->closeLink();
+    break;
+  case XML_FOOT:
+    m_collector->closeFoot();
+    break;
+  case XML_ENDNOTE:
+    m_collector->closeEndnote();
+    break;
+  case XML_FIELD:
+    m_collector->closeField();
+    break;
+  case XML_TABLE:
+    m_collector->closeTable();
+    break;
+  case XML_CELL:
+    m_collector->closeCell();
+    break;
+  case XML_FRAME:
+    readCloseFrame();
+    break;
+  default:
+    break;
+  }
 }
 
-void libabw::ABWParser::readAbiword(xmlTextReaderPtr reader)
+void libabw::ABWParser::countNode(const unsigned long depth)
 {
-  const ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
-  if (m_collector)
-    m_collector->collectDocumentProperties(static_cast<const char *>(props));
+  if (m_control)
+  {
+    m_control->checkCancelled();
+    m_control->checkNodeCount(++m_state->m_nodeCount);
+    m_control->checkDepth(depth);
+  }
+  if (m_statistics && m_state->m_inStyleParsing)
+    ++m_statistics->m_nodeCount;
 }
 
-void libabw::ABWParser::readM(xmlTextReaderPtr reader)
+void libabw::ABWParser::readTextNode(const char *const text, const bool blank, const bool atEndTag)
 {
-  const ABWXMLString key = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("key"));
-  if (key)
-    m_state->m_currentMetadataKey = static_cast<const char *>(key);
+  ABWBlankTextFilter &filter = m_state->m_blankTextFilter;
+  if (!filter.addText(text, blank, atEndTag))
+    return;
+  countNode(filter.getDepth());
+  if (blank)
+    readSignificantWhitespace(text);
+  else
+    readText(text);
 }
 
-int libabw::ABWParser::readHistory(xmlTextReaderPtr reader)
+void libabw::ABWParser::readText(const char *const text)
 {
-  int ret = 1;
-  int tokenId = XML_TOKEN_INVALID;
-  int tokenType = -1;
-  do
+  ABW_DEBUG_MSG(("ABWParser::readText: text %s\n", text));
+  if (m_state->m_inMetadata)
   {
-    ret = xmlTextReaderRead(reader);
-    tokenId = getElementToken(reader);
-    if (XML_TOKEN_INVALID == tokenId)
+    if (m_state->m_currentMetadataKey.empty())
     {
-      ABW_DEBUG_MSG(("ABWParser::readHistory: unknown token %s\n", xmlTextReaderConstName(reader)));
+      ABW_DEBUG_MSG(("there is no key for metadata entry '%s'\n", text));
     }
-    tokenType = xmlTextReaderNodeType(reader);
-    switch (tokenId)
+    else
     {
-    default:
-      break;
+      m_collector->addMetadataEntry(m_state->m_currentMetadataKey.c_str(), text);
+      m_state->m_currentMetadataKey.clear();
     }
   }
-  while ((XML_HISTORY != tokenId || XML_READER_TYPE_END_ELEMENT != tokenType) && 1 == ret);
-  return ret;
+  else
+  {
+    m_collector->insertText(text);
+  }
 }
 
-int libabw::ABWParser::readRevisions(xmlTextReaderPtr reader)
+void libabw::ABWParser::readSignificantWhitespace(const char *const text)
 {
-  int ret = 1;
-  int tokenId = XML_TOKEN_INVALID;
-  int tokenType = -1;
-  do
-  {
-    ret = xmlTextReaderRead(reader);
-    tokenId = getElementToken(reader);
-    if (XML_TOKEN_INVALID == tokenId)
-    {
-      ABW_DEBUG_MSG(("ABWParser::readRevisions: unknown token %s\n", xmlTextReaderConstName(reader)));
-    }
-    tokenType = xmlTextReaderNodeType(reader);
-    (void)tokenType;
-    switch (tokenId)
-    {
-    default:
-      break;
-    }
-  }
-  while ((XML_REVISIONS != tokenId || XML_READER_TYPE_END_ELEMENT != tokenType) && 1 == ret);
-  return ret;
+  if (!m_state->m_inMetadata && text && text[0]==' ' && text[1]==0)
+    m_collector->insertText(text);
 }
 
-int libabw::ABWParser::readIgnoredWords(xmlTextReaderPtr reader)
+void libabw::ABWParser::readData(const char *const name, const char *const mimeType, const bool base64,
+                                 const char *const data, const unsigned long length)
 {
-  int ret = 1;
-  int tokenId = XML_TOKEN_INVALID;
-  int tokenType = -1;
-  do
+  if (m_dataDecoder)
   {
-    ret = xmlTextReaderRead(reader);
-    tokenId = getElementToken(reader);
-    if (XML_TOKEN_INVALID == tokenId)
-    {
-      ABW_DEBUG_MSG(("ABWParser::readIgnoreWords: unknown token %s\n", xmlTextReaderConstName(reader)));
-    }
-    tokenType = xmlTextReaderNodeType(reader);
-    switch (tokenId)
-    {
-    default:
-      break;
-    }
+    m_dataDecoder->add(name, mimeType, base64, data, length, m_control);
+    return;
   }
-  while ((XML_IGNOREDWORDS != tokenId || XML_READER_TYPE_END_ELEMENT != tokenType) && 1 == ret);
-  return ret;
+  // do not decode data that cannot fit in the limit: 4 characters of
+  // base64 decode to at most 3 bytes
+  if (m_control && m_state->m_inStyleParsing)
+    m_control->checkDataBytes(base64 ? length / 4 * 3 : length);
+  librevenge::RVNGBinaryData binaryData;
+  if (base64)
+  {
+    binaryData.appendBase64Data(data);
+    if (m_statistics && m_state->m_inStyleParsing)
+      m_statistics->m_base64DecodedBytes += binaryData.size();
+  }
+  else
+    binaryData.append(reinterpret_cast<const unsigned char *>(data), length);
+  // the data are only stored in the styles pass
+  if (m_control && m_state->m_inStyleParsing)
+    m_control->addDataBytes(binaryData.size());
+  if (m_collector)
+    m_collector->collectData(name, mimeType, binaryData);
+}
+
+void libabw::ABWParser::readAbiword(ABWXMLAttributes &attributes)
+{
+  const char *const props = attributes.get("props");
+  if (m_collector)
+    m_collector->collectDocumentProperties(static_cast<const char *>(props));
+}
+
+void libabw::ABWParser::readM(ABWXMLAttributes &attributes)
+{
+  const char *const key = attributes.get("key");
+  if (key)
+    m_state->m_currentMetadataKey = static_cast<const char *>(key);
 }
 
-void libabw::ABWParser::readPageSize(xmlTextReaderPtr reader)
+void libabw::ABWParser::readPageSize(ABWXMLAttributes &attributes)
 {
-  ABWXMLString width = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("width"));
-  ABWXMLString height = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("height"));
-  ABWXMLString units = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("units"));
-  ABWXMLString pageScale = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("page-scale"));
+  const char *const width = attributes.get("width");
+  const char *const height = attributes.get("height");
+  const char *const units = attributes.get("units");
+  const char *const pageScale = attributes.get("page-scale");
   if (m_collector)
-    m_collector->collectPageSize((const char *)width, (const char *)height, (const char *)units, (const char *)pageScale);
+    m_collector->collectPageSize(width, height, units, pageScale);
 }
 
-void libabw::ABWParser::readSection(xmlTextReaderPtr reader)
+void libabw::ABWParser::readSection(ABWXMLAttributes &attributes)
 {
-  ABWXMLString id = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("id"));
-  ABWXMLString type = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("type"));
-  ABWXMLString footer = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("footer"));
-  ABWXMLString footerLeft = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("footer-even"));
-  ABWXMLString footerFirst = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("footer-first"));
-  ABWXMLString footerLast = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("footer-last"));
-  ABWXMLString header = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("header"));
-  ABWXMLString headerLeft = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("header-even"));
-  ABWXMLString headerFirst = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("header-first"));
-  ABWXMLString headerLast = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("header-last"));
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
+  const char *const id = attributes.get("id");
+  const char *const type = attributes.get("type");
+  const char *const footer = attributes.get("footer");
+  const char *const footerLeft = attributes.get("footer-even");
+  const char *const footerFirst = attributes.get("footer-first");
+  const char *const footerLast = attributes.get("footer-last");
+  const char *const header = attributes.get("header");
+  const char *const headerLeft = attributes.get("header-even");
+  const char *const headerFirst = attributes.get("header-first");
+  const char *const headerLast = attributes.get("header-last");
+  const char *const props = attributes.get("props");
 
-  if (!type || (xmlStrncmp(type.get(), call_BAD_CAST_OnConst("header"), 6) && xmlStrncmp(type.get(), call_BAD_CAST_OnConst("footer"), 6)))
+  if (!type || (strncmp(type, "header", 6) && strncmp(type, "footer", 6)))
   {
     if (m_collector)
-      m_collector->collectSectionProperties((const char *)footer, (const char *)footerLeft,
-                                            (const char *)footerFirst, (const char *)footerLast,
-                                            (const char *)header, (const char *)headerLeft,
-                                            (const char *)headerFirst, (const char *)headerLast,
-                                            (const char *)props);
+      m_collector->collectSectionProperties(footer, footerLeft,
+                                            footerFirst, footerLast,
+                                            header, headerLeft,
+                                            headerFirst, headerLast,
+                                            props);
   }
   else
   {
     if (m_collector)
-      m_collector->collectHeaderFooter((const char *)id, (const char *)type);
+      m_collector->collectHeaderFooter(id, type);
   }
 }
 
 int libabw::ABWParser::readD(xmlTextReaderPtr reader)
 {
-  ABWXMLString name = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("name"));
-  ABWXMLString mimeType = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("mime-type"));
+  ABWReaderAttributes attributes(reader);
+  const char *const name = attributes.get("name");
+  const char *const mimeType = attributes.get("mime-type");
 
-  ABWXMLString tmpBase64 = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("base64"));
+  const char *const tmpBase64 = attributes.get("base64");
   bool base64(false);
   if (tmpBase64)
   {
-    findBool((const char *)tmpBase64, base64);
+    findBool(tmpBase64, base64);
   }
 
   int ret = 1;
@@ -538,15 +1760,7 @@ int libabw::ABWParser::readD(xmlTextReaderPtr reader)
     {
       const xmlChar *data = xmlTextReaderConstValue(reader);
       if (data)
-      {
-        librevenge::RVNGBinaryData binaryData;
-        if (base64)
-          binaryData.appendBase64Data((const char *)data);
-        else
-          binaryData.append(data, (unsigned long) xmlStrlen(data));
-        if (m_collector)
-          m_collector->collectData((const char *)name, (const char *)mimeType, binaryData);
-      }
+        readData(name, mimeType, base64, (const char *)data, (unsigned long) xmlStrlen(data));
       break;
     }
     default:
@@ -557,13 +1771,13 @@ int libabw::ABWParser::readD(xmlTextReaderPtr reader)
   return ret;
 }
 
-void libabw::ABWParser::readS(xmlTextReaderPtr reader)
+void libabw::ABWParser::readS(ABWXMLAttributes &attributes)
 {
-  ABWXMLString type = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("type"));
-  ABWXMLString name = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("name"));
-  ABWXMLString basedon = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("basedon"));
-  ABWXMLString followedby = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("followedby"));
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
+  const char *const type = attributes.get("type");
+  const char *const name = attributes.get("name");
+  const char *const basedon = attributes.get("basedon");
+  const char *const followedby = attributes.get("followedby");
+  const char *const props = attributes.get("props");
   if (type)
   {
     if (m_collector)
@@ -572,7 +1786,7 @@ void libabw::ABWParser::readS(xmlTextReaderPtr reader)
       {
       case 'P':
       case 'C':
-        m_collector->collectTextStyle((const char *)name, (const char *)basedon, (const char *)followedby, (const char *)props);
+        m_collector->collectTextStyle(name, basedon, followedby, props);
         break;
       default:
         break;
@@ -581,129 +1795,126 @@ void libabw::ABWParser::readS(xmlTextReaderPtr reader)
   }
 }
 
-void libabw::ABWParser::readA(xmlTextReaderPtr reader)
+void libabw::ABWParser::readA(ABWXMLAttributes &attributes)
 {
-  ABWXMLString href = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("xlink:href"));
+  const char *const href = attributes.get("xlink:href");
   if (m_collector)
-    m_collector->openLink((const char *)href);
+    m_collector->openLink(href);
 }
 
-void libabw::ABWParser::readP(xmlTextReaderPtr reader)
+void libabw::ABWParser::readP(ABWXMLAttributes &attributes)
 {
-  ABWXMLString level = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("level"));
-  ABWXMLString listid = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("listid"));
-  ABWXMLString parentid = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("parentid"));
-  ABWXMLString style = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("style"));
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
+  const char *const level = attributes.get("level");
+  const char *const listid = attributes.get("listid");
+  const char *const parentid = attributes.get("parentid");
+  const char *const style = attributes.get("style");
+  const char *const props = attributes.get("props");
   if (m_collector)
-    m_collector->collectParagraphProperties((const char *)level, (const char *)listid, (const char *)parentid,
-                                            (const char *)style, (const char *)props);
+    m_collector->collectParagraphProperties(level, listid, parentid,
+                                            style, props);
 }
 
-void libabw::ABWParser::readC(xmlTextReaderPtr reader)
+void libabw::ABWParser::readC(ABWXMLAttributes &attributes)
 {
-  ABWXMLString style = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("style"));
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
+  const char *const style = attributes.get("style");
+  const char *const props = attributes.get("props");
   if (m_collector)
-    m_collector->collectCharacterProperties((const char *)style, (const char *)props);
+    m_collector->collectCharacterProperties(style, props);
 
 }
 
-void libabw::ABWParser::readEndnote(xmlTextReaderPtr reader)
+void libabw::ABWParser::readEndnote(ABWXMLAttributes &attributes)
 {
-  ABWXMLString id = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("endnote-id"));
+  const char *const id = attributes.get("endnote-id");
   if (m_collector)
-    m_collector->openEndnote((const char *)id);
+    m_collector->openEndnote(id);
 }
 
-void libabw::ABWParser::readField(xmlTextReaderPtr reader)
+void libabw::ABWParser::readField(ABWXMLAttributes &attributes)
 {
-  ABWXMLString type = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("type"));
-  //ABWXMLString style = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("style"));
-  //ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
-  ABWXMLString id = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("xid"));
+  const char *const type = attributes.get("type");
+  //const char *const style = attributes.get("style");
+  //const char *const props = attributes.get("props");
+  const char *const id = attributes.get("xid");
   if (m_collector)
     m_collector->openField(type, id);
 }
 
-void libabw::ABWParser::readFoot(xmlTextReaderPtr reader)
+void libabw::ABWParser::readFoot(ABWXMLAttributes &attributes)
 {
-  ABWXMLString id = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("footnote-id"));
+  const char *const id = attributes.get("footnote-id");
   if (m_collector)
-    m_collector->openFoot((const char *)id);
+    m_collector->openFoot(id);
 }
 
-void libabw::ABWParser::readTable(xmlTextReaderPtr reader)
+void libabw::ABWParser::readTable(ABWXMLAttributes &attributes)
 {
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
+  const char *const props = attributes.get("props");
   if (m_collector)
-    m_collector->openTable((const char *)props);
+    m_collector->openTable(props);
 }
 
-void libabw::ABWParser::readCell(xmlTextReaderPtr reader)
+void libabw::ABWParser::readCell(ABWXMLAttributes &attributes)
 {
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
+  const char *const props = attributes.get("props");
   if (m_collector)
-    m_collector->openCell((const char *)props);
+    m_collector->openCell(props);
 }
 
-void libabw::ABWParser::readImage(xmlTextReaderPtr reader)
+void libabw::ABWParser::readImage(ABWXMLAttributes &attributes)
 {
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
-  ABWXMLString dataid = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("dataid"));
+  const char *const props = attributes.get("props");
+  const char *const dataid = attributes.get("dataid");
   if (m_collector)
-    m_collector->insertImage((const char *)dataid, (const char *)props);
+    m_collector->insertImage(dataid, props);
 }
 
-void libabw::ABWParser::readFrame(xmlTextReaderPtr reader)
+void libabw::ABWParser::readFrame(ABWXMLAttributes &attributes)
 {
   if (!m_collector)
     return;
-  ABWXMLString props = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("props"));
-  ABWXMLString imageId = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("strux-image-dataid"));
-  ABWXMLString title = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("title"));
-  ABWXMLString alt = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("alt"));
+  const char *const props = attributes.get("props");
+  const char *const imageId = attributes.get("strux-image-dataid");
+  const char *const title = attributes.get("title");
+  const char *const alt = attributes.get("alt");
   if (!m_state->m_inStyleParsing)
-  {
-    m_state->m_collectorStack.push(std::move(m_collector));
-    m_collector.reset(new ABWContentCollector(m_iface, m_state->m_tableSizes, m_state->m_data, m_state->m_listElements));
-  }
-  m_collector->openFrame((const char *)props, (const char *) imageId, (const char *) title, (const char *) alt);
+    ++m_state->m_frameDepth;
+  m_collector->openFrame(props, imageId, title, alt);
 }
 
 void libabw::ABWParser::readCloseFrame()
 {
   if (!m_collector)
     return;
+  if (!m_state->m_inStyleParsing)
+  {
+    if (m_state->m_frameDepth==0)
+    {
+      ABW_DEBUG_MSG(("libabw::ABWParser::readCloseFrame: oops, no frame is opened\n"));
+      return; // throw ?
+    }
+    --m_state->m_frameDepth;
+  }
   ABWOutputElements *elements=nullptr;
   bool pageFrame=false;
   m_collector->closeFrame(elements,pageFrame);
-  if (m_state->m_inStyleParsing)
-    return;
-  if (m_state->m_collectorStack.empty())
-  {
-    ABW_DEBUG_MSG(("libabw::ABWParser::readCloseFrame: oops, the collector stack is empty\n"));
-    return; // throw ?
-  }
   if (elements)
-    m_state->m_collectorStack.top()->addFrameElements(*elements, pageFrame);
-  m_collector.swap(m_state->m_collectorStack.top());
-  m_state->m_collectorStack.pop();
+    m_collector->addFrameElements(*elements, pageFrame);
 }
 
-void libabw::ABWParser::readL(xmlTextReaderPtr reader)
+void libabw::ABWParser::readL(ABWXMLAttributes &attributes)
 {
-  ABWXMLString id = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("id"));
-  ABWXMLString listDecimal = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("list-decimal"));
+  const char *const id = attributes.get("id");
+  const char *listDecimal = attributes.get("list-decimal");
   if (!listDecimal)
-    listDecimal = xmlCharStrdup("NULL");
-  ABWXMLString listDelim = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("list-delim"));
-  ABWXMLString parentid = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("parentid"));
-  ABWXMLString startValue = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("start-value"));
-  ABWXMLString type = xmlTextReaderGetAttribute(reader, call_BAD_CAST_OnConst("type"));
+    listDecimal = "NULL";
+  const char *const listDelim = attributes.get("list-delim");
+  const char *const parentid = attributes.get("parentid");
+  const char *const startValue = attributes.get("start-value");
+  const char *const type = attributes.get("type");
   if (m_collector)
-    m_collector->collectList((const char *)id, (const char *)listDecimal, (const char *)listDelim,
-                             (const char *)parentid, (const char *)startValue, (const char *)type);
+    m_collector->collectList(id, listDecimal, listDelim,
+                             parentid, startValue, type);
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
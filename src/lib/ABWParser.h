@@ -13,20 +13,43 @@
 #include <memory>
 
 #include <librevenge/librevenge.h>
+#include <libabw/AbiParseOptions.h>
+#include "ABWCollector.h"
 #include "ABWXMLHelper.h"
 
 namespace libabw
 {
 
-class ABWCollector;
+struct AbiParseStatistics;
+class ABWContentWorkers;
+class ABWDataDecoder;
+class ABWParseControl;
 struct ABWParserState;
+class ABWSAXHandler;
+
+//! The attributes of the current element, independent of the XML frontend.
+class ABWXMLAttributes
+{
+public:
+  virtual ~ABWXMLAttributes() {}
+  //! the value of the attribute with the qualified name, or nullptr; valid as long as this object
+  virtual const char *get(const char *name) = 0;
+};
 
 class ABWParser
 {
+  friend class ABWContentWorkers;
+  friend class ABWSAXHandler;
+
 public:
-  explicit ABWParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *iface);
+  explicit ABWParser(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *iface,
+                     AbiParseStatistics *statistics = nullptr, ABWParseControl *control = nullptr,
+                     ABWXMLFrontend frontend = ABW_XML_READER, unsigned contentThreads = 0,
+                     unsigned dataThreads = 0);
   virtual ~ABWParser();
   bool parse();
+  //! read only the metadata, which precede the content
+  bool parseMetadata(ABWPropertyMap &metadata);
 
 private:
   ABWParser();
@@ -36,39 +59,64 @@ private:
   // Helper functions
 
   int getElementToken(xmlTextReaderPtr reader);
+  void collectNodeStatistics(xmlTextReaderPtr reader, int tokenId, int tokenType);
+  void collectElementStatistics(int tokenId, unsigned long attributeBytes);
 
   // Functions to read the AWML document structure
 
+  //! parse the document in one pass and finish the collection
   bool processXmlDocument(librevenge::RVNGInputStream *input);
+  //! the content pass, in parts on several threads if possible
+  bool processContent();
+  bool parseXmlDocument(librevenge::RVNGInputStream *input);
+  bool parseXmlDocumentSAX(librevenge::RVNGInputStream *input);
   int processXmlNode(xmlTextReaderPtr reader);
 
-  void readAbiword(xmlTextReaderPtr reader);
-  void readM(xmlTextReaderPtr reader);
-  int readHistory(xmlTextReaderPtr reader);
-  int readRevisions(xmlTextReaderPtr reader);
-  int readIgnoredWords(xmlTextReaderPtr reader);
-  void readPageSize(xmlTextReaderPtr reader);
-  void readSection(xmlTextReaderPtr reader);
-  void readA(xmlTextReaderPtr reader);
-  void readC(xmlTextReaderPtr reader);
+  // Functions shared by the XML frontends
+
+  //! whether the element is skipped with its contents
+  bool isElementSkipped(int tokenId) const;
+  void startElement(int tokenId, ABWXMLAttributes &attributes);
+  void endElement(int tokenId);
+  //! does the cancel and limit checks and the statistics of a node at the depth
+  void countNode(unsigned long depth);
+  //! a text node, which may be dropped if it is blank; atEndTag if the end tag of the element follows it
+  void readTextNode(const char *text, bool blank, bool atEndTag);
+  void readText(const char *text);
+  void readSignificantWhitespace(const char *text);
+  void readData(const char *name, const char *mimeType, bool base64, const char *data, unsigned long length);
+
+  void readAbiword(ABWXMLAttributes &attributes);
+  void readM(ABWXMLAttributes &attributes);
+  void readPageSize(ABWXMLAttributes &attributes);
+  void readSection(ABWXMLAttributes &attributes);
+  void readA(ABWXMLAttributes &attributes);
+  void readC(ABWXMLAttributes &attributes);
   int readD(xmlTextReaderPtr reader);
-  void readL(xmlTextReaderPtr reader);
-  void readP(xmlTextReaderPtr reader);
-  void readS(xmlTextReaderPtr reader);
-  void readEndnote(xmlTextReaderPtr reader);
-  void readFoot(xmlTextReaderPtr reader);
-  void readField(xmlTextReaderPtr reader);
-  void readImage(xmlTextReaderPtr reader);
-
-  void readTable(xmlTextReaderPtr reader);
-  void readCell(xmlTextReaderPtr reader);
-
-  void readFrame(xmlTextReaderPtr reader);
+  void readL(ABWXMLAttributes &attributes);
+  void readP(ABWXMLAttributes &attributes);
+  void readS(ABWXMLAttributes &attributes);
+  void readEndnote(ABWXMLAttributes &attributes);
+  void readFoot(ABWXMLAttributes &attributes);
+  void readField(ABWXMLAttributes &attributes);
+  void readImage(ABWXMLAttributes &attributes);
+
+  void readTable(ABWXMLAttributes &attributes);
+  void readCell(ABWXMLAttributes &attributes);
+
+  void readFrame(ABWXMLAttributes &attributes);
   void readCloseFrame();
 
   librevenge::RVNGInputStream *m_input;
   librevenge::RVNGTextInterface *m_iface;
+  AbiParseStatistics *m_statistics;
+  ABWParseControl *m_control;
+  ABWXMLFrontend m_frontend;
+  unsigned m_contentThreads;
+  unsigned m_dataThreads;
   std::unique_ptr<ABWCollector> m_collector;
+  //! decodes the data in the styles pass, if that is done on other threads
+  std::unique_ptr<ABWDataDecoder> m_dataDecoder;
   std::unique_ptr<ABWParserState> m_state;
 };
 
@@ -14,6 +14,7 @@
 
 #include <librevenge/librevenge.h>
 #include "ABWStylesCollector.h"
+#include "ABWValueMap.h"
 
 #define ABW_EPSILON 1.0E-06
 
@@ -128,10 +129,16 @@ libabw::ABWStylesTableState::ABWStylesTableState(const ABWStylesTableState &ts)
 libabw::ABWStylesTableState::~ABWStylesTableState() {}
 
 libabw::ABWStylesParsingState::ABWStylesParsingState() :
-  m_tableStates() {}
+  m_tableStates(),
+  m_lastLevel(),
+  m_lastProps(),
+  m_hasLastParagraph(false) {}
 
 libabw::ABWStylesParsingState::ABWStylesParsingState(const ABWStylesParsingState &ps) :
-  m_tableStates(ps.m_tableStates) {}
+  m_tableStates(ps.m_tableStates),
+  m_lastLevel(ps.m_lastLevel),
+  m_lastProps(ps.m_lastProps),
+  m_hasLastParagraph(ps.m_hasLastParagraph) {}
 
 libabw::ABWStylesParsingState::~ABWStylesParsingState() {}
 
@@ -346,74 +353,122 @@ void libabw::ABWStylesCollector::collectList(const char *id, const char *, const
 
 void libabw::ABWStylesCollector::collectParagraphProperties(const char *level, const char *listid, const char *parentid, const char * /* style */, const char *props)
 {
-  ABWPropertyMap properties;
-  if (props)
-    parsePropString(props, properties);
-
-  int intParentId(0);
-  if (!parentid || !findInt(parentid, intParentId) || intParentId < 0)
-    intParentId = 0;
   int intListId(0);
   if (!listid || !findInt(listid, intListId) || intListId < 0)
     intListId = 0;
 
-  auto iter = m_listElements.find(intListId);
+  /* All paragraphs without a list share the list element 0: the first
+     one creates it, and each one replaces its level and indentation.
+     So only the last one matters, and it is processed in endDocument().
+    */
+  if (intListId == 0)
+  {
+    const auto iter = m_listElements.find(0);
+    if (iter != m_listElements.end() && iter->second)
+    {
+      m_ps->m_lastLevel = level ? level : "";
+      m_ps->m_lastProps = props ? props : "";
+      m_ps->m_hasLastParagraph = true;
+      return;
+    }
+  }
+
+  _processParagraph(intListId, level, parentid, props);
+}
+
+void libabw::ABWStylesCollector::endDocument()
+{
+  if (m_ps->m_hasLastParagraph)
+    _processParagraph(0, m_ps->m_lastLevel.c_str(), nullptr, m_ps->m_lastProps.c_str());
+  m_ps->m_hasLastParagraph = false;
+}
+
+void libabw::ABWStylesCollector::_processParagraph(const int listId, const char *const level, const char *const parentid, const char *const props)
+{
+  enum { LIST_STYLE, START_VALUE, MARGIN_LEFT, TEXT_INDENT, PROPERTY_COUNT };
+  static const char *const names[PROPERTY_COUNT] = { "list-style", "start-value", "margin-left", "text-indent" };
+  std::string values[PROPERTY_COUNT];
+  findProperties(props, names, values, PROPERTY_COUNT);
+
+  auto iter = m_listElements.find(listId);
   if (iter == m_listElements.end() || !iter->second)
   {
-    ABWPropertyMap::const_iterator i = properties.find("list-style");
+    int intParentId(0);
+    if (!parentid || !findInt(parentid, intParentId) || intParentId < 0)
+      intParentId = 0;
     int listStyle(NOT_A_LIST);
-    if (i != properties.end())
+    if (!values[LIST_STYLE].empty())
     {
-      if (i->second == "Numbered List")
+      switch (ABWValueMap::getValueId(values[LIST_STYLE]))
+      {
+      case VALUE_NUMBERED_LIST:
         listStyle = NUMBERED_LIST;
-      else if (i->second == "Lower Case List")
+        break;
+      case VALUE_LOWER_CASE_LIST:
         listStyle = LOWERCASE_LIST;
-      else if (i->second == "Upper Case List")
+        break;
+      case VALUE_UPPER_CASE_LIST:
         listStyle = UPPERCASE_LIST;
-      else if (i->second == "Lower Roman List")
+        break;
+      case VALUE_LOWER_ROMAN_LIST:
         listStyle = LOWERROMAN_LIST;
-      else if (i->second == "Upper Roman List")
+        break;
+      case VALUE_UPPER_ROMAN_LIST:
         listStyle = UPPERROMAN_LIST;
-      else if (i->second == "Hebrew List")
+        break;
+      case VALUE_HEBREW_LIST:
         listStyle = HEBREW_LIST;
-      else if (i->second == "Arabic List")
+        break;
+      case VALUE_ARABIC_LIST:
         listStyle = ARABICNUMBERED_LIST;
-      else if (i->second == "Bullet List")
+        break;
+      case VALUE_BULLET_LIST:
         listStyle = BULLETED_LIST;
-      else if (i->second == "Dashed List")
+        break;
+      case VALUE_DASHED_LIST:
         listStyle = DASHED_LIST;
-      else if (i->second == "Square List")
+        break;
+      case VALUE_SQUARE_LIST:
         listStyle = SQUARE_LIST;
-      else if (i->second == "Triangle List")
+        break;
+      case VALUE_TRIANGLE_LIST:
         listStyle = TRIANGLE_LIST;
-      else if (i->second == "Diamond List")
+        break;
+      case VALUE_DIAMOND_LIST:
         listStyle = DIAMOND_LIST;
-      else if (i->second == "Star List")
+        break;
+      case VALUE_STAR_LIST:
         listStyle = STAR_LIST;
-      else if (i->second == "Implies List")
+        break;
+      case VALUE_IMPLIES_LIST:
         listStyle = IMPLIES_LIST;
-      else if (i->second == "Tick List")
+        break;
+      case VALUE_TICK_LIST:
         listStyle = TICK_LIST;
-      else if (i->second == "Box List")
+        break;
+      case VALUE_BOX_LIST:
         listStyle = BOX_LIST;
-      else if (i->second == "Hand List")
+        break;
+      case VALUE_HAND_LIST:
         listStyle = HAND_LIST;
-      else if (i->second == "Heart List")
+        break;
+      case VALUE_HEART_LIST:
         listStyle = HEART_LIST;
-      else if (i->second == "Arrowhead List")
+        break;
+      case VALUE_ARROWHEAD_LIST:
         listStyle = ARROWHEAD_LIST;
-      else
+        break;
+      default:
         listStyle = NOT_A_LIST;
+        break;
+      }
     }
-    i = properties.find("start-value");
-    std::string startValue;
-    if (i != properties.end())
-      startValue = i->second;
+    const std::string &startValue = values[START_VALUE];
     int intStartValue(0);
     if (startValue.empty() || findInt(startValue, intStartValue) || intStartValue < 0)
       intStartValue = 0;
-    _processList(intListId, "%L", intParentId, intStartValue, listStyle);
-    iter = m_listElements.find(intListId);
+    _processList(listId, "%L", intParentId, intStartValue, listStyle);
+    iter = m_listElements.find(listId);
   }
   if (iter != m_listElements.end() && iter->second)
   {
@@ -422,14 +477,12 @@ void libabw::ABWStylesCollector::collectParagraphProperties(const char *level, c
     if (!level || !findInt(level, listElement->m_listLevel) || listElement->m_listLevel < 0)
       listElement->m_listLevel = 0;
 
-    ABWPropertyMap::const_iterator i = properties.find("margin-left");
     ABWUnit unit(ABW_NONE);
     double marginLeft(0.0);
-    if (i == properties.end() || !findDouble(i->second, marginLeft, unit) || unit != ABW_IN)
+    if (!findDouble(values[MARGIN_LEFT], marginLeft, unit) || unit != ABW_IN)
       marginLeft = 0.0;
-    i = properties.find("text-indent");
     double textIndent(0.0);
-    if (i == properties.end() || !findDouble(i->second, textIndent, unit) || unit != ABW_IN)
+    if (!findDouble(values[TEXT_INDENT], textIndent, unit) || unit != ABW_IN)
       textIndent = 0.0;
     listElement->m_minLabelWidth = -textIndent;
     listElement->m_spaceBefore = marginLeft + textIndent;
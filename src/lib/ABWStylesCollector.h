@@ -38,6 +38,11 @@ struct ABWStylesParsingState
   ~ABWStylesParsingState();
 
   std::stack<ABWStylesTableState> m_tableStates;
+
+  //! the level and props of the last paragraph without a list
+  std::string m_lastLevel;
+  std::string m_lastProps;
+  bool m_hasLastParagraph;
 };
 
 class ABWStylesCollector : public ABWCollector
@@ -71,7 +76,7 @@ public:
   void closeField() override {}
   void endSection() override {}
   void startDocument() override {}
-  void endDocument() override {}
+  void endDocument() override;
   void insertLineBreak() override {}
   void insertColumnBreak() override {}
   void insertPageBreak() override {}
@@ -103,6 +108,7 @@ private:
 
   std::string _findCellProperty(const char *name);
   void _processList(int id, const char *listDelim, int parentid, int startValue, int type);
+  void _processParagraph(int listId, const char *level, const char *parentid, const char *props);
 
   std::unique_ptr<ABWStylesParsingState> m_ps;
   std::map<int, int> &m_tableSizes;
@@ -0,0 +1,37 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#ifndef __ABWVALUEMAP_H__
+#define __ABWVALUEMAP_H__
+
+#include <string>
+#include "values.h"
+
+namespace libabw
+{
+
+/** Maps the values of enumerated AbiWord properties (list styles, field
+    types, wrap modes, ...) to the VALUE_* tokens listed in values.txt.
+  */
+class ABWValueMap
+{
+public:
+  //! get the token of a value, or VALUE_TOKEN_INVALID if the value is unknown
+  static int getValueId(const char *value, std::size_t length);
+  static int getValueId(const std::string &value)
+  {
+    return getValueId(value.c_str(), value.size());
+  }
+};
+
+} // namespace libabw
+
+#endif /* __ABWVALUEMAP_H__ */
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
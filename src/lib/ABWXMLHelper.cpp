@@ -7,11 +7,16 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <limits.h>
 #include <string.h>
 #include <libxml/xmlIO.h>
 #include <libxml/xmlmemory.h>
+#include <libxml/parserInternals.h>
 #include <librevenge-stream/librevenge-stream.h>
+#include <libabw/AbiMappedFileStream.h>
+#include "ABWMemoryStream.h"
 #include "ABWXMLHelper.h"
+#include "ABWZlibStream.h"
 #include "libabw_internal.h"
 
 namespace libabw
@@ -77,6 +82,24 @@ extern "C" {
 
 } // anonymous namespace
 
+const unsigned char *getStreamData(librevenge::RVNGInputStream *input, unsigned long &size)
+{
+  size = 0;
+  if (const auto *const stream = dynamic_cast<const ABWZlibStream *>(input))
+    return stream->getData(size);
+  if (const auto *const stream = dynamic_cast<const AbiMappedFileStream *>(input))
+  {
+    size = stream->getSize();
+    return stream->getData();
+  }
+  if (const auto *const stream = dynamic_cast<const ABWMemoryStream *>(input))
+  {
+    size = stream->getSize();
+    return stream->getData();
+  }
+  return nullptr;
+}
+
 ABWXMLString::ABWXMLString(xmlChar *xml)
   : m_xml(xml, xmlFree)
 {
@@ -111,6 +134,11 @@ bool ABWXMLProgressWatcher::isStuck() const
   return m_isStuck;
 }
 
+bool ABWXMLProgressWatcher::hasError() const
+{
+  return m_wasError;
+}
+
 void ABWXMLProgressWatcher::signalError()
 {
   if (m_reader && !m_isStuck)
@@ -130,10 +158,20 @@ void ABWXMLProgressWatcher::signalError()
 
 std::unique_ptr<xmlTextReader, void(*)(xmlTextReaderPtr)> xmlReaderForStream(librevenge::RVNGInputStream *input, ABWXMLProgressWatcher *watcher)
 {
-  std::unique_ptr<xmlTextReader, void(*)(xmlTextReaderPtr)> reader(
-    xmlReaderForIO(abwxmlInputReadFunc, abwxmlInputCloseFunc, (void *)input, nullptr, nullptr,
-                   XML_PARSE_NOBLANKS|XML_PARSE_NONET|XML_PARSE_RECOVER),
-    xmlFreeTextReader);
+  // the blanks are left to the reader; which libxml2 drops can depend on how it splits the input
+  const int options = XML_PARSE_NONET|XML_PARSE_RECOVER;
+  std::unique_ptr<xmlTextReader, void(*)(xmlTextReaderPtr)> reader(nullptr, xmlFreeTextReader);
+
+  // If the document is in memory already, let libxml2 parse it in place,
+  // instead of copying it chunk by chunk.
+  unsigned long size = 0;
+  const unsigned char *data = getStreamData(input, size);
+  const long offset = input ? input->tell() : 0;
+  if (data && offset >= 0 && static_cast<unsigned long>(offset) <= size && size - static_cast<unsigned long>(offset) <= INT_MAX)
+    reader.reset(xmlReaderForMemory(reinterpret_cast<const char *>(data) + offset, int(size - static_cast<unsigned long>(offset)),
+                                    nullptr, nullptr, options));
+  else
+    reader.reset(xmlReaderForIO(abwxmlInputReadFunc, abwxmlInputCloseFunc, (void *)input, nullptr, nullptr, options));
   if (watcher)
     watcher->setReader(reader.get());
   if (reader)
@@ -141,6 +179,34 @@ std::unique_ptr<xmlTextReader, void(*)(xmlTextReaderPtr)> xmlReaderForStream(lib
   return reader;
 }
 
+// xmlParserCtxt helper function
+
+std::unique_ptr<xmlParserCtxt, void(*)(xmlParserCtxtPtr)> xmlParserForStream(librevenge::RVNGInputStream *input, const xmlSAXHandler *sax, void *userData)
+{
+  // the blanks are left to the handler
+  const int options = XML_PARSE_NONET|XML_PARSE_RECOVER;
+  std::unique_ptr<xmlParserCtxt, void(*)(xmlParserCtxtPtr)> context(nullptr, xmlFreeParserCtxt);
+
+  unsigned long size = 0;
+  const unsigned char *data = getStreamData(input, size);
+  const long offset = input ? input->tell() : 0;
+  if (data && offset >= 0 && static_cast<unsigned long>(offset) <= size && size - static_cast<unsigned long>(offset) <= INT_MAX)
+  {
+    context.reset(xmlCreateMemoryParserCtxt(reinterpret_cast<const char *>(data) + offset, int(size - static_cast<unsigned long>(offset))));
+    if (context && context->sax)
+    {
+      *context->sax = *sax;
+      context->userData = userData;
+    }
+  }
+  else
+    context.reset(xmlCreateIOParserCtxt(const_cast<xmlSAXHandler *>(sax), userData, abwxmlInputReadFunc, abwxmlInputCloseFunc,
+                                        (void *)input, XML_CHAR_ENCODING_NONE));
+  if (context)
+    xmlCtxtUseOptions(context.get(), options);
+  return context;
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
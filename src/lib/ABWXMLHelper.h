@@ -14,6 +14,7 @@
 
 #include <librevenge-stream/librevenge-stream.h>
 
+#include <libxml/parser.h>
 #include <libxml/xmlreader.h>
 #include <libxml/xmlstring.h>
 
@@ -45,6 +46,8 @@ public:
   void setReader(xmlTextReaderPtr reader);
 
   bool isStuck() const;
+  //! whether an error was signalled
+  bool hasError() const;
   void signalError();
 
 private:
@@ -55,9 +58,15 @@ private:
   bool m_isStuck;
 };
 
+// the whole document, if the stream has it in memory; nullptr otherwise
+const unsigned char *getStreamData(librevenge::RVNGInputStream *input, unsigned long &size);
+
 // create an xmlTextReader pointer from a librevenge::RVNGInputStream pointer
 std::unique_ptr<xmlTextReader, void(*)(xmlTextReaderPtr)> xmlReaderForStream(librevenge::RVNGInputStream *input, ABWXMLProgressWatcher *watcher = nullptr);
 
+// create an xmlParserCtxt, which reports to the SAX handler, from a librevenge::RVNGInputStream pointer
+std::unique_ptr<xmlParserCtxt, void(*)(xmlParserCtxtPtr)> xmlParserForStream(librevenge::RVNGInputStream *input, const xmlSAXHandler *sax, void *userData);
+
 } // namespace libabw
 
 #endif // __ABWXMLHELPER_H__
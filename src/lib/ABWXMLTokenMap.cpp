@@ -9,6 +9,7 @@
 
 #include "ABWXMLTokenMap.h"
 #include <string.h>
+#include "libabw_internal.h"
 
 namespace
 {
@@ -26,4 +27,14 @@ int libabw::ABWXMLTokenMap::getTokenId(const xmlChar *name)
     return XML_TOKEN_INVALID;
 }
 
+const char *libabw::ABWXMLTokenMap::getTokenName(int tokenId)
+{
+  for (std::size_t i = 0; i != ABW_NUM_ELEMENTS(wordlist); ++i)
+  {
+    if (wordlist[i].name && wordlist[i].tokenId == tokenId)
+      return wordlist[i].name;
+  }
+  return nullptr;
+}
+
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
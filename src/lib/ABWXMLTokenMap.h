@@ -20,6 +20,8 @@ class ABWXMLTokenMap
 {
 public:
   static int getTokenId(const xmlChar *name);
+  //! get the element name of a token, or nullptr if the id is unknown
+  static const char *getTokenName(int tokenId);
 };
 
 } // namespace libabw
@@ -7,11 +7,26 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
-#include <zlib.h>
 #include "ABWZlibStream.h"
+#include "ABWDecompressor.h"
+#include "ABWParseControl.h"
+#include "libabw_internal.h"
+#include "ABWInflate.h"
+#include <libabw/AbiMappedFileStream.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <system_error>
+#include <thread>
 #include <string.h>  // for memcpy
 
 #define BLOCK_SIZE 16384
+// compressed documents inflating to more than this are not kept in memory
+#define MAX_BUFFERED_SIZE (16 * 1024 * 1024)
+// the minimal distance of two checkpoints in the inflated data
+#define CHECKPOINT_SPAN (1024 * 1024)
+// the amount of data the inflater thread may inflate ahead; a power of 2
+#define PIPELINE_BUFFER_SIZE (1024 * 1024)
 
 namespace libabw
 {
@@ -19,82 +34,502 @@ namespace libabw
 namespace
 {
 
-static bool getInflatedBuffer(librevenge::RVNGInputStream *input, std::vector<unsigned char> &buffer)
+static bool getDecompressedBuffer(librevenge::RVNGInputStream *input, ABWDecompressor::Format format, unsigned long size,
+                                  std::vector<unsigned char> &buffer, ABWParseControl *control)
 {
-  int ret;
-  z_stream strm;
-  unsigned char in[BLOCK_SIZE];
-  unsigned char out[BLOCK_SIZE];
+  std::unique_ptr<ABWDecompressor> decompressor(ABWDecompressor::create(format, size));
+  if (!decompressor)
+  {
+    ABW_DEBUG_MSG(("getDecompressedBuffer: libabw was built without support for this compression format\n"));
+    return false;
+  }
+  if (decompressor->decompress(input, size, buffer, control))
+    return true;
+  // the size might be wrong, e.g. if there are several gzip members
+  if (decompressor->getBackend() == ABWDecompressor::BACKEND_LIBDEFLATE)
+    return ABWDecompressor::create(ABWDecompressor::BACKEND_INFLATE)->decompress(input, 0, buffer, control);
+  return false;
+}
+
+/* Returns the compression format of the input. For gzip, size is set to
+   the size of the inflated document stored in its trailer (modulo 2^32),
+   or to 0 if the input cannot seek to its end. */
+static ABWDecompressor::Format getFormat(librevenge::RVNGInputStream *input, unsigned long &size)
+{
+  size = 0;
+  if (!input)
+    return ABWDecompressor::FORMAT_NONE;
+  unsigned long numBytesRead(0);
+  const unsigned char *p = input->read(6, numBytesRead);
+  const ABWDecompressor::Format format = ABWDecompressor::detectFormat(p, p ? numBytesRead : 0);
+  if (format == ABWDecompressor::FORMAT_GZIP && input->seek(-4, librevenge::RVNG_SEEK_END) == 0)
+  {
+    p = input->read(4, numBytesRead);
+    if (p && numBytesRead == 4)
+      size = (unsigned long)p[0] | ((unsigned long)p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+  }
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  return format;
+}
 
-  strm.zalloc = Z_NULL;
-  strm.zfree = Z_NULL;
-  strm.opaque = Z_NULL;
-  strm.avail_in = 0;
-  strm.next_in = Z_NULL;
-  ret = inflateInit2(&strm, 16 + MAX_WBITS);
-  if (Z_OK != ret)
+}
+
+/** Inflates a gzip stream on demand, with zlib or zlib-ng.
+
+    While inflating, the state at deflate block boundaries is recorded
+    every CHECKPOINT_SPAN bytes: the position in the compressed input, the
+    number of bits of the previous byte belonging to the next block and the
+    32 KiB window. The inflation can then be restarted from any of these
+    checkpoints, like in zlib's zran example, so seeking back only needs
+    to inflate a part of the document again.
+  */
+class ABWZlibInflater
+{
+public:
+  ABWZlibInflater(librevenge::RVNGInputStream *input, ABWParseControl *control);
+  ~ABWZlibInflater();
+
+  //! inflate from the current position to buffer; returns the number of inflated bytes
+  unsigned long inflate(unsigned char *buffer, unsigned long size);
+  //! move to the offset in the inflated data; returns false if it cannot be reached
+  bool seek(unsigned long offset);
+  //! move to the end of the document
+  void seekToEnd();
+
+  unsigned long tell() const
+  {
+    return m_offset;
+  }
+  bool isEnd() const
+  {
+    return m_isEnd;
+  }
+  bool isOk() const
+  {
+    return !m_isError;
+  }
+  //! the size of the data inflated so far; can be called while another thread inflates
+  unsigned long getSize() const
+  {
+    return m_size.load(std::memory_order_relaxed);
+  }
+  //! the control of the parsing; must be nullptr while inflating on another thread
+  void setControl(ABWParseControl *control)
+  {
+    m_control = control;
+  }
+
+private:
+  struct Checkpoint
+  {
+    Checkpoint() : m_in(0), m_out(0), m_bits(0), m_window() {}
+
+    unsigned long m_in;
+    unsigned long m_out;
+    int m_bits;
+    std::vector<unsigned char> m_window;
+  };
+
+  //! start inflating again from the checkpoint, or from the beginning if it is nullptr
+  bool restart(const Checkpoint *checkpoint);
+  void addCheckpoint();
+
+  librevenge::RVNGInputStream *m_input;
+  ABWParseControl *m_control;
+  ABWZStream m_strm;
+  bool m_isInitialized;
+  std::vector<unsigned char> m_in;
+  //! the number of bytes read from the input
+  unsigned long m_inOffset;
+  unsigned long m_offset;
+  std::atomic<unsigned long> m_size;
+  bool m_isEnd;
+  bool m_isError;
+  std::vector<Checkpoint> m_checkpoints;
+
+  ABWZlibInflater(const ABWZlibInflater &);
+  ABWZlibInflater &operator=(const ABWZlibInflater &);
+};
+
+ABWZlibInflater::ABWZlibInflater(librevenge::RVNGInputStream *input, ABWParseControl *control)
+  : m_input(input)
+  , m_control(control)
+  , m_strm()
+  , m_isInitialized(false)
+  , m_in(BLOCK_SIZE)
+  , m_inOffset(0)
+  , m_offset(0)
+  , m_size(0)
+  , m_isEnd(false)
+  , m_isError(false)
+  , m_checkpoints()
+{
+  m_isError = !restart(nullptr);
+}
+
+ABWZlibInflater::~ABWZlibInflater()
+{
+  if (m_isInitialized)
+    (void)abwInflateEnd(&m_strm);
+}
+
+bool ABWZlibInflater::restart(const Checkpoint *const checkpoint)
+{
+  if (m_isInitialized)
+    (void)abwInflateEnd(&m_strm);
+  m_isInitialized = false;
+  m_isEnd = false;
+  m_isError = true;
+
+  m_strm.zalloc = nullptr;
+  m_strm.zfree = nullptr;
+  m_strm.opaque = nullptr;
+  m_strm.avail_in = 0;
+  m_strm.next_in = nullptr;
+  // the checkpoints are inside the deflate data, so there is no gzip header to skip
+  if (Z_OK != abwInflateInit2(&m_strm, checkpoint ? -MAX_WBITS : 16 + MAX_WBITS))
     return false;
+  m_isInitialized = true;
 
-  do
+  if (!checkpoint)
   {
-    unsigned long numBytesRead(0);
-    const unsigned char *p = input->read(BLOCK_SIZE, numBytesRead);
-    strm.avail_in = uInt(numBytesRead);
-    if (!strm.avail_in)
-      break;
-    memcpy(in, p, strm.avail_in);
-    strm.next_in = in;
+    if (m_input->seek(0, librevenge::RVNG_SEEK_SET))
+      return false;
+    m_inOffset = 0;
+    m_offset = 0;
+  }
+  else
+  {
+    const unsigned long pos = checkpoint->m_in - (checkpoint->m_bits ? 1 : 0);
+    if (m_input->seek(long(pos), librevenge::RVNG_SEEK_SET))
+      return false;
+    m_inOffset = pos;
+    if (checkpoint->m_bits)
+    {
+      unsigned long numBytesRead(0);
+      const unsigned char *p = m_input->read(1, numBytesRead);
+      if (!p || numBytesRead != 1)
+        return false;
+      ++m_inOffset;
+      if (Z_OK != abwInflatePrime(&m_strm, checkpoint->m_bits, p[0] >> (8 - checkpoint->m_bits)))
+        return false;
+    }
+    if (Z_OK != abwInflateSetDictionary(&m_strm, &checkpoint->m_window[0], ABWZSize(checkpoint->m_window.size())))
+      return false;
+    m_offset = checkpoint->m_out;
+  }
+  m_isError = false;
+  return true;
+}
 
-    do
+void ABWZlibInflater::addCheckpoint()
+{
+  Checkpoint checkpoint;
+  checkpoint.m_in = m_inOffset - m_strm.avail_in;
+  checkpoint.m_out = m_offset;
+  checkpoint.m_bits = m_strm.data_type & 7;
+  checkpoint.m_window.resize(1U << MAX_WBITS);
+  ABWZSize length = 0;
+  if (Z_OK != abwInflateGetDictionary(&m_strm, &checkpoint.m_window[0], &length) || !length)
+    return;
+  checkpoint.m_window.resize(length);
+  m_checkpoints.push_back(std::move(checkpoint));
+}
+
+unsigned long ABWZlibInflater::inflate(unsigned char *const buffer, const unsigned long size)
+{
+  if (!m_isInitialized)
+    return 0;
+  m_strm.next_out = buffer;
+  m_strm.avail_out = ABWZSize(size);
+  while (m_strm.avail_out && !m_isEnd && !m_isError)
+  {
+    if (!m_strm.avail_in)
     {
-      strm.avail_out = BLOCK_SIZE;
-      strm.next_out = out;
-      ret = inflate(&strm, Z_NO_FLUSH);
-      switch (ret)
+      if (m_control)
+        m_control->checkCancelled();
+      // the input may have been used by someone else since the last read
+      if (m_input->tell() != long(m_inOffset) && m_input->seek(long(m_inOffset), librevenge::RVNG_SEEK_SET))
       {
-      case Z_NEED_DICT:
-      case Z_DATA_ERROR:
-      case Z_MEM_ERROR:
-      case Z_STREAM_ERROR:
-        (void)inflateEnd(&strm);
-        return false;
-      default:
+        m_isError = true;
+        break;
+      }
+      unsigned long numBytesRead(0);
+      const unsigned char *p = m_input->read(BLOCK_SIZE, numBytesRead);
+      if (!p || !numBytesRead)
+      {
+        m_isError = true; // truncated
         break;
       }
-      for (unsigned i = 0; i < BLOCK_SIZE - strm.avail_out; ++i)
-        buffer.push_back(out[i]);
+      memcpy(&m_in[0], p, numBytesRead);
+      m_strm.next_in = &m_in[0];
+      m_strm.avail_in = ABWZSize(numBytesRead);
+      m_inOffset += numBytesRead;
+    }
+
+    const ABWZSize availOut = m_strm.avail_out;
+    const int ret = abwInflate(&m_strm, Z_BLOCK);
+    m_offset += availOut - m_strm.avail_out;
+    if (Z_STREAM_END == ret)
+      m_isEnd = true;
+    else if (Z_OK != ret && Z_BUF_ERROR != ret)
+      m_isError = true;
+    else if ((m_strm.data_type & 128) && !(m_strm.data_type & 64)) // at the end of a block, but not of the last one
+    {
+      const unsigned long last = m_checkpoints.empty() ? 0 : m_checkpoints.back().m_out;
+      if (m_offset >= last + CHECKPOINT_SPAN)
+        addCheckpoint();
     }
-    while (!strm.avail_out);
   }
-  while (Z_STREAM_END != ret);
 
-  (void)inflateEnd(&strm);
-  input->seek(0, librevenge::RVNG_SEEK_SET);
-  if (Z_STREAM_END == ret)
-    return true;
-  return false;
+  if (m_offset > getSize())
+  {
+    m_size.store(m_offset, std::memory_order_relaxed);
+    if (m_control)
+      m_control->checkInflatedSize(m_offset);
+  }
+  return size - m_strm.avail_out;
 }
 
+bool ABWZlibInflater::seek(const unsigned long offset)
+{
+  // the last checkpoint not after offset
+  const auto it = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), offset,
+                                   [](unsigned long value, const Checkpoint &checkpoint)
+  {
+    return value < checkpoint.m_out;
+  });
+  const Checkpoint *const checkpoint = it == m_checkpoints.begin() ? nullptr : &*(it - 1);
+
+  if (offset < m_offset || m_isError || (checkpoint && checkpoint->m_out > m_offset))
+  {
+    if (!restart(checkpoint))
+      return false;
+  }
+
+  unsigned char skipped[BLOCK_SIZE];
+  while (m_offset < offset && !m_isEnd && !m_isError)
+    inflate(skipped, std::min<unsigned long>(BLOCK_SIZE, offset - m_offset));
+  return m_offset == offset;
+}
+
+void ABWZlibInflater::seekToEnd()
+{
+  unsigned char skipped[BLOCK_SIZE];
+  while (!m_isEnd && !m_isError)
+    inflate(skipped, BLOCK_SIZE);
 }
 
-ABWZlibStream::ABWZlibStream(librevenge::RVNGInputStream *input) :
+namespace
+{
+
+/** A lock-free byte queue between one producer and one consumer thread.
+
+    Each side only writes its own index, and reads the other one to know
+    how much it can copy.
+  */
+class ABWByteRing
+{
+public:
+  explicit ABWByteRing(size_t capacity)
+    : m_data(capacity)
+    , m_head(0)
+    , m_tail(0)
+  {
+  }
+
+  //! append up to size bytes; returns the number of appended bytes
+  size_t push(const unsigned char *data, size_t size)
+  {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    const size_t tail = m_tail.load(std::memory_order_acquire);
+    const size_t count = std::min(size, m_data.size() - (head - tail));
+    const size_t start = head & (m_data.size() - 1);
+    const size_t first = std::min(count, m_data.size() - start);
+    memcpy(&m_data[start], data, first);
+    memcpy(&m_data[0], data + first, count - first);
+    m_head.store(head + count, std::memory_order_release);
+    return count;
+  }
+
+  //! remove up to size bytes; returns the number of removed bytes
+  size_t pop(unsigned char *data, size_t size)
+  {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t head = m_head.load(std::memory_order_acquire);
+    const size_t count = std::min(size, head - tail);
+    const size_t start = tail & (m_data.size() - 1);
+    const size_t first = std::min(count, m_data.size() - start);
+    memcpy(data, &m_data[start], first);
+    memcpy(data + first, &m_data[0], count - first);
+    m_tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  //! to be called by the consumer
+  bool empty() const
+  {
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::vector<unsigned char> m_data;
+  //! the number of bytes pushed so far
+  std::atomic<size_t> m_head;
+  //! the number of bytes popped so far
+  std::atomic<size_t> m_tail;
+};
+
+void waitForOtherThread(unsigned &round)
+{
+  if (++round < 64)
+    std::this_thread::yield();
+  else
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+}
+
+/** Runs an inflater on a separate thread, ahead of the reading.
+
+    The inflater belongs to the thread until this object is destroyed.
+    What the inflation throws is rethrown by read(), once the data
+    inflated before are read.
+  */
+class ABWInflaterThread
+{
+public:
+  explicit ABWInflaterThread(ABWZlibInflater &inflater);
+  ~ABWInflaterThread();
+
+  //! read up to size bytes, waiting until some are available; returns 0 at the end
+  unsigned long read(unsigned char *buffer, unsigned long size);
+  bool isEnd();
+
+private:
+  void run();
+
+  ABWZlibInflater &m_inflater;
+  ABWByteRing m_ring;
+  std::atomic<bool> m_stop;
+  std::atomic<bool> m_isFinished;
+  //! what the inflation threw; set before m_isFinished
+  std::exception_ptr m_exception;
+  std::thread m_thread;
+
+  ABWInflaterThread(const ABWInflaterThread &);
+  ABWInflaterThread &operator=(const ABWInflaterThread &);
+};
+
+ABWInflaterThread::ABWInflaterThread(ABWZlibInflater &inflater)
+  : m_inflater(inflater)
+  , m_ring(PIPELINE_BUFFER_SIZE)
+  , m_stop(false)
+  , m_isFinished(false)
+  , m_exception()
+  , m_thread()
+{
+  m_thread = std::thread(&ABWInflaterThread::run, this);
+}
+
+ABWInflaterThread::~ABWInflaterThread()
+{
+  m_stop.store(true, std::memory_order_release);
+  m_thread.join();
+}
+
+void ABWInflaterThread::run()
+{
+  try
+  {
+    unsigned char chunk[BLOCK_SIZE];
+    while (!m_stop.load(std::memory_order_acquire))
+    {
+      const unsigned long size = m_inflater.inflate(chunk, BLOCK_SIZE);
+      if (!size)
+        break;
+      unsigned round = 0;
+      for (unsigned long pushed = m_ring.push(chunk, size); pushed < size; pushed += m_ring.push(chunk + pushed, size - pushed))
+      {
+        if (m_stop.load(std::memory_order_acquire))
+          return;
+        waitForOtherThread(round);
+      }
+    }
+  }
+  catch (...)
+  {
+    m_exception = std::current_exception();
+  }
+  m_isFinished.store(true, std::memory_order_release);
+}
+
+unsigned long ABWInflaterThread::read(unsigned char *const buffer, const unsigned long size)
+{
+  unsigned round = 0;
+  while (true)
+  {
+    // check the flag first, so no data pushed before it was set is missed
+    const bool isFinished = m_isFinished.load(std::memory_order_acquire);
+    const unsigned long count = m_ring.pop(buffer, size);
+    if (!count && isFinished && m_exception)
+      std::rethrow_exception(m_exception);
+    if (count || isFinished)
+      return count;
+    waitForOtherThread(round);
+  }
+}
+
+bool ABWInflaterThread::isEnd()
+{
+  return m_isFinished.load(std::memory_order_acquire) && m_ring.empty();
+}
+
+ABWZlibStream::ABWZlibStream(librevenge::RVNGInputStream *input, ABWParseControl *control, bool pipelined) :
   librevenge::RVNGInputStream(),
   m_input(nullptr),
   m_offset(0),
-  m_buffer()
+  m_buffer(),
+  m_inflater(),
+  m_inflaterThread(),
+  m_control(control),
+  m_pipelined(pipelined)
 {
-  if (!getInflatedBuffer(input, m_buffer))
+  unsigned long size(0);
+  const ABWDecompressor::Format format = getFormat(input, size);
+  if (format == ABWDecompressor::FORMAT_GZIP && size > MAX_BUFFERED_SIZE)
+  {
+    if (control)
+      control->checkInflatedSize(size);
+    m_inflater.reset(new ABWZlibInflater(input, control));
+    if (m_inflater->isOk())
+      return;
+    m_inflater.reset();
+  }
+  if (format == ABWDecompressor::FORMAT_NONE || !getDecompressedBuffer(input, format, size, m_buffer, control))
   {
+    m_buffer.clear();
     if (input)
     {
-      input->seek(0, librevenge::RVNG_SEEK_CUR);
+      input->seek(0, librevenge::RVNG_SEEK_SET);
       m_input = input;
     }
-    else
-      m_buffer.clear();
   }
 }
 
+ABWZlibStream::~ABWZlibStream()
+{
+  stopInflaterThread();
+}
+
+void ABWZlibStream::stopInflaterThread()
+{
+  if (!m_inflaterThread)
+    return;
+  m_inflaterThread.reset();
+  m_inflater->setControl(m_control);
+}
+
 const unsigned char *ABWZlibStream::read(unsigned long numBytes, unsigned long &numBytesRead)
 {
   if (m_input)
@@ -108,6 +543,55 @@ const unsigned char *ABWZlibStream::read(unsigned long numBytes, unsigned long &
   if (m_offset < 0)
     return nullptr;
 
+  if (m_inflater)
+  {
+    try
+    {
+      if (m_buffer.size() < numBytes)
+        m_buffer.resize(numBytes);
+      if (m_pipelined && !m_inflaterThread)
+      {
+        if (m_inflater->tell() != static_cast<unsigned long>(m_offset) && !m_inflater->seek(static_cast<unsigned long>(m_offset)))
+          return nullptr;
+        // the control is not thread-safe, so the limit is checked here
+        m_inflater->setControl(nullptr);
+        try
+        {
+          m_inflaterThread.reset(new ABWInflaterThread(*m_inflater));
+        }
+        catch (const std::system_error &)
+        {
+          ABW_DEBUG_MSG(("ABWZlibStream::read: cannot start the inflater thread\n"));
+          m_inflater->setControl(m_control);
+          m_pipelined = false;
+        }
+      }
+      if (m_inflaterThread)
+      {
+        numBytesRead = m_inflaterThread->read(&m_buffer[0], numBytes);
+        if (m_control)
+          m_control->checkInflatedSize(static_cast<unsigned long>(m_offset) + numBytesRead);
+      }
+      else
+      {
+        if (m_inflater->tell() != static_cast<unsigned long>(m_offset) && !m_inflater->seek(static_cast<unsigned long>(m_offset)))
+          return nullptr;
+        numBytesRead = m_inflater->inflate(&m_buffer[0], numBytes);
+      }
+    }
+    catch (...)
+    {
+      // this is called from libxml2, which cannot pass exceptions through
+      if (m_control)
+        m_control->deferException(std::current_exception());
+      numBytesRead = 0;
+    }
+    if (numBytesRead == 0)
+      return nullptr;
+    m_offset += numBytesRead;
+    return &m_buffer[0];
+  }
+
   const unsigned long bufSize = m_buffer.size();
   const unsigned long pos = static_cast<unsigned long>(m_offset);
   const unsigned long remaining = pos < bufSize ? bufSize - pos : 0;
@@ -124,11 +608,61 @@ const unsigned char *ABWZlibStream::read(unsigned long numBytes, unsigned long &
   return &m_buffer[size_t(oldOffset)];
 }
 
+unsigned long ABWZlibStream::getSize() const
+{
+  if (m_inflater)
+    return m_inflater->getSize();
+  return m_buffer.size();
+}
+
+const unsigned char *ABWZlibStream::getData(unsigned long &size) const
+{
+  size = 0;
+  if (m_inflater)
+    return nullptr;
+  if (m_input)
+  {
+    const auto *const mapped = dynamic_cast<const AbiMappedFileStream *>(m_input);
+    if (mapped)
+    {
+      size = mapped->getSize();
+      return mapped->getData();
+    }
+    return nullptr;
+  }
+  if (m_buffer.empty())
+    return nullptr;
+  size = m_buffer.size();
+  return &m_buffer[0];
+}
+
 int ABWZlibStream::seek(long offset, librevenge::RVNG_SEEK_TYPE seekType)
 {
   if (m_input)
     return m_input->seek(offset, seekType);
 
+  if (m_inflater)
+  {
+    if (m_inflaterThread)
+    {
+      if ((seekType == librevenge::RVNG_SEEK_SET && offset == m_offset) || (seekType == librevenge::RVNG_SEEK_CUR && offset == 0))
+        return 0;
+      stopInflaterThread();
+    }
+    if (seekType == librevenge::RVNG_SEEK_CUR)
+      offset += m_offset;
+    else if (seekType == librevenge::RVNG_SEEK_END)
+    {
+      m_inflater->seekToEnd();
+      offset += long(m_inflater->tell());
+    }
+    if (offset < 0)
+      offset = 0;
+    const bool isReached = m_inflater->seek(static_cast<unsigned long>(offset));
+    m_offset = long(m_inflater->tell());
+    return isReached ? 0 : 1;
+  }
+
   if (seekType == librevenge::RVNG_SEEK_CUR)
     m_offset += offset;
   else if (seekType == librevenge::RVNG_SEEK_SET)
@@ -161,6 +695,11 @@ bool ABWZlibStream::isEnd()
   if (m_input)
     return m_input->isEnd();
 
+  if (m_inflaterThread)
+    return m_inflaterThread->isEnd();
+  if (m_inflater)
+    return m_inflater->tell() == static_cast<unsigned long>(m_offset) && (m_inflater->isEnd() || !m_inflater->isOk());
+
   if ((long)m_offset >= (long)m_buffer.size())
     return true;
 
@@ -10,17 +10,34 @@
 #ifndef __ABWZLIBSTREAM_H__
 #define __ABWZLIBSTREAM_H__
 
+#include <memory>
 #include <vector>
 #include <librevenge-stream/librevenge-stream.h>
 
 namespace libabw
 {
 
+class ABWParseControl;
+class ABWZlibInflater;
+class ABWInflaterThread;
+
+/** Input stream transparently decompressing compressed documents.
+
+    Documents that are not compressed are read directly from the input.
+    Compressed documents are decompressed into memory, unless they are
+    large gzip files: those are inflated on demand, and seeking back
+    restarts the inflation from the nearest checkpoint recorded on the way.
+    Besides gzip, xz and zstd are recognized if libabw was built with
+    support for them (see ABWDecompressor).
+
+    If pipelined, large gzip files are inflated on a separate thread,
+    ahead of the reading.
+  */
 class ABWZlibStream : public librevenge::RVNGInputStream
 {
 public:
-  ABWZlibStream(librevenge::RVNGInputStream *input);
-  ~ABWZlibStream() override {}
+  ABWZlibStream(librevenge::RVNGInputStream *input, ABWParseControl *control = nullptr, bool pipelined = false);
+  ~ABWZlibStream() override;
 
   bool isStructured() override
   {
@@ -50,14 +67,21 @@ public:
   int seek(long offset, librevenge::RVNG_SEEK_TYPE seekType) override;
   long tell() override;
   bool isEnd() override;
-  unsigned long getSize() const
-  {
-    return m_buffer.size();
-  }
+  //! the size of the inflated document; for large documents, of the part inflated so far
+  unsigned long getSize() const;
+  //! the whole document, if it is contiguous in memory; nullptr otherwise
+  const unsigned char *getData(unsigned long &size) const;
 private:
+  void stopInflaterThread();
+
   librevenge::RVNGInputStream *m_input;
   volatile long m_offset;
   std::vector<unsigned char> m_buffer;
+  std::unique_ptr<ABWZlibInflater> m_inflater;
+  //! the thread using m_inflater, if it is running
+  std::unique_ptr<ABWInflaterThread> m_inflaterThread;
+  ABWParseControl *m_control;
+  bool m_pipelined;
   ABWZlibStream(const ABWZlibStream &);
   ABWZlibStream &operator=(const ABWZlibStream &);
 };
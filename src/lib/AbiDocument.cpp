@@ -7,21 +7,12 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
+#include <memory>
+
 #include <libabw/libabw.h>
-#include "ABWXMLHelper.h"
-#include "ABWParser.h"
-#include "ABWZlibStream.h"
+#include "ABWParseControl.h"
 #include "libabw_internal.h"
 
-namespace libabw
-{
-// small function needed to call the xml BAD_CAST on a char const *
-static xmlChar *call_BAD_CAST_OnConst(char const *str)
-{
-  return BAD_CAST(const_cast<char *>(str));
-}
-}
-
 /**
 \mainpage libabw documentation
 This document contains both the libabw API specification and the normal libabw
@@ -48,38 +39,8 @@ ABWAPI bool libabw::AbiDocument::isFileFormatSupported(librevenge::RVNGInputStre
   ABW_DEBUG_MSG(("AbiDocument::isFileFormatSupported\n"));
   if (!input)
     return false;
-  input->seek(0, librevenge::RVNG_SEEK_SET);
-  libabw::ABWZlibStream stream(input);
-  stream.seek(0, librevenge::RVNG_SEEK_SET);
-  auto reader = libabw::xmlReaderForStream(&stream);
-  if (!reader)
-    return false;
-  int ret = xmlTextReaderRead(reader.get());
-  while (ret == 1 && XML_READER_TYPE_ELEMENT != xmlTextReaderNodeType(reader.get()))
-    ret = xmlTextReaderRead(reader.get());
-  if (ret != 1)
-    return false;
-  const xmlChar *name = xmlTextReaderConstName(reader.get());
-  if (!name)
-    return false;
-  if (!xmlStrEqual(name, call_BAD_CAST_OnConst("abiword")))
-  {
-    if (!xmlStrEqual(name, call_BAD_CAST_OnConst("awml")))
-      return false;
-  }
-
-  // Checking the namespace of AbiWord documents.
-  const xmlChar *nsname = xmlTextReaderConstNamespaceUri(reader.get());
-  if (!nsname)
-#if 1
-    return true; // Have seen some abiword files without NS declaration
-#else
-    return false;
-#endif
-  if (!xmlStrEqual(nsname, call_BAD_CAST_OnConst("http://www.abisource.com/awml.dtd")))
-    return false;
-
-  return true;
+  const std::unique_ptr<AbiPreparedDocument> document(open(input));
+  return document->isSupported();
 }
 catch (...)
 {
@@ -97,21 +58,85 @@ is not protected
 \return A value that indicates whether the conversion was successful and in case it
 was not, it indicates the reason of the error
 */
-ABWAPI bool libabw::AbiDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *textInterface) try
+ABWAPI bool libabw::AbiDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *textInterface)
+{
+  return parse(input, textInterface, nullptr);
+}
+
+/**
+Parses the input stream content, like parse(librevenge::RVNGInputStream *, librevenge::RVNGTextInterface *),
+and collects timings and counters of the parsing.
+\param input The input stream
+\param textInterface A librevenge::RVNGTextInterface implementation
+\param statistics The statistics to add the measurements to, or NULL if
+nothing should be measured
+\return A value that indicates whether the conversion was successful
+*/
+ABWAPI bool libabw::AbiDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *textInterface,
+                                       AbiParseStatistics *statistics)
+{
+  AbiParseOptions options;
+  options.m_statistics = statistics;
+  return parse(input, textInterface, options) == ABW_OK;
+}
+
+/**
+Parses the input stream content, like parse(librevenge::RVNGInputStream *, librevenge::RVNGTextInterface *),
+with additional options.
+\param input The input stream
+\param textInterface A librevenge::RVNGTextInterface implementation
+\param options The options of the parsing, e.g. its cancellation flag, deadline and resource limits
+\return ABW_OK if the conversion was successful, ABW_CANCELLED if it was
+aborted through the options, ABW_LIMIT_EXCEEDED if the document exceeds
+one of the limits, ABW_PARSE_ERROR otherwise
+*/
+ABWAPI libabw::ABWResult libabw::AbiDocument::parse(librevenge::RVNGInputStream *input, librevenge::RVNGTextInterface *textInterface,
+                                                    const AbiParseOptions &options) try
 {
   ABW_DEBUG_MSG(("AbiDocument::parse\n"));
   if (!input)
-    return false;
-  input->seek(0, librevenge::RVNG_SEEK_SET);
-  libabw::ABWZlibStream stream(input);
-  libabw::ABWParser parser(&stream, textInterface);
-  if (parser.parse())
-    return true;
-  return false;
+    return ABW_PARSE_ERROR;
+  const std::unique_ptr<AbiPreparedDocument> document(open(input, options));
+  return document->parse(textInterface, options);
+}
+catch (const ABWCancelledException &)
+{
+  return ABW_CANCELLED;
+}
+catch (const ABWLimitExceededException &)
+{
+  return ABW_LIMIT_EXCEEDED;
 }
 catch (...)
 {
-  return false;
+  return ABW_PARSE_ERROR;
+}
+
+/**
+Opens the input stream for repeated use. A compressed document is
+decompressed only once, and the detection of the format, the reading of
+the metadata and the parsing of the returned document all use the result.
+\param input The input stream; it must exist as long as the returned document
+\return The opened document, which the caller owns and must delete; if the
+input cannot be read, it is not supported and its parsing fails
+*/
+ABWAPI libabw::AbiPreparedDocument *libabw::AbiDocument::open(librevenge::RVNGInputStream *input)
+{
+  return open(input, AbiParseOptions());
+}
+
+/**
+Opens the input stream for repeated use, like open(librevenge::RVNGInputStream *).
+\param input The input stream; it must exist as long as the returned document
+\param options The options of the decompression: its cancellation flag,
+deadline, resource limits, pipelining and statistics
+\return The opened document, which the caller owns and must delete
+*/
+ABWAPI libabw::AbiPreparedDocument *libabw::AbiDocument::open(librevenge::RVNGInputStream *input,
+                                                             const AbiParseOptions &options)
+{
+  ABW_DEBUG_MSG(("AbiDocument::open\n"));
+  return new AbiPreparedDocument(input, options);
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,220 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <libabw/AbiMappedFileStream.h>
+
+#ifdef _WIN32
+#include <stdio.h>
+#include <vector>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "libabw_internal.h"
+
+namespace libabw
+{
+
+struct AbiMappedFileStream::Impl
+{
+  Impl();
+  ~Impl();
+
+  void open(const char *filename);
+
+  const unsigned char *m_data;
+  unsigned long m_size;
+  unsigned long m_offset;
+#ifdef _WIN32
+  // there is no mmap: read the whole file instead
+  std::vector<unsigned char> m_buffer;
+#endif
+
+private:
+  Impl(const Impl &);
+  Impl &operator=(const Impl &);
+};
+
+AbiMappedFileStream::Impl::Impl()
+  : m_data(nullptr)
+  , m_size(0)
+  , m_offset(0)
+#ifdef _WIN32
+  , m_buffer()
+#endif
+{
+}
+
+#ifdef _WIN32
+
+AbiMappedFileStream::Impl::~Impl()
+{
+}
+
+void AbiMappedFileStream::Impl::open(const char *const filename)
+{
+  FILE *const file = fopen(filename, "rb");
+  if (!file)
+    return;
+  if (fseek(file, 0, SEEK_END) == 0)
+  {
+    const long size = ftell(file);
+    if (size > 0 && fseek(file, 0, SEEK_SET) == 0)
+    {
+      m_buffer.resize(static_cast<size_t>(size));
+      if (fread(&m_buffer[0], 1, m_buffer.size(), file) == m_buffer.size())
+      {
+        m_data = &m_buffer[0];
+        m_size = static_cast<unsigned long>(size);
+      }
+      else
+        m_buffer.clear();
+    }
+  }
+  fclose(file);
+}
+
+#else
+
+AbiMappedFileStream::Impl::~Impl()
+{
+  if (m_data)
+    munmap(const_cast<unsigned char *>(m_data), m_size);
+}
+
+void AbiMappedFileStream::Impl::open(const char *const filename)
+{
+  const int fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+  {
+    void *const data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+    {
+      m_data = static_cast<const unsigned char *>(data);
+      m_size = static_cast<unsigned long>(info.st_size);
+      // both passes read the file from start to end
+      (void)madvise(data, m_size, MADV_SEQUENTIAL);
+    }
+    else
+    {
+      ABW_DEBUG_MSG(("AbiMappedFileStream: cannot map %s\n", filename));
+    }
+  }
+  close(fd);
+}
+
+#endif
+
+AbiMappedFileStream::AbiMappedFileStream(const char *const filename)
+  : librevenge::RVNGInputStream()
+  , m_impl(new Impl())
+{
+  if (filename)
+    m_impl->open(filename);
+}
+
+AbiMappedFileStream::~AbiMappedFileStream()
+{
+}
+
+bool AbiMappedFileStream::isStructured()
+{
+  return false;
+}
+
+unsigned AbiMappedFileStream::subStreamCount()
+{
+  return 0;
+}
+
+const char *AbiMappedFileStream::subStreamName(unsigned)
+{
+  return nullptr;
+}
+
+bool AbiMappedFileStream::existsSubStream(const char *)
+{
+  return false;
+}
+
+librevenge::RVNGInputStream *AbiMappedFileStream::getSubStreamByName(const char *)
+{
+  return nullptr;
+}
+
+librevenge::RVNGInputStream *AbiMappedFileStream::getSubStreamById(unsigned)
+{
+  return nullptr;
+}
+
+const unsigned char *AbiMappedFileStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+{
+  numBytesRead = 0;
+  if (numBytes == 0 || m_impl->m_offset >= m_impl->m_size)
+    return nullptr;
+
+  const unsigned long remaining = m_impl->m_size - m_impl->m_offset;
+  numBytesRead = numBytes < remaining ? numBytes : remaining;
+  const unsigned char *const data = m_impl->m_data + m_impl->m_offset;
+  m_impl->m_offset += numBytesRead;
+  return data;
+}
+
+int AbiMappedFileStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+{
+  long pos = offset;
+  if (seekType == librevenge::RVNG_SEEK_CUR)
+    pos += long(m_impl->m_offset);
+  else if (seekType == librevenge::RVNG_SEEK_END)
+    pos += long(m_impl->m_size);
+
+  if (pos < 0)
+  {
+    m_impl->m_offset = 0;
+    return 1;
+  }
+  if (pos > long(m_impl->m_size))
+  {
+    m_impl->m_offset = m_impl->m_size;
+    return 1;
+  }
+
+  m_impl->m_offset = static_cast<unsigned long>(pos);
+  return 0;
+}
+
+long AbiMappedFileStream::tell()
+{
+  return long(m_impl->m_offset);
+}
+
+bool AbiMappedFileStream::isEnd()
+{
+  return m_impl->m_offset >= m_impl->m_size;
+}
+
+const unsigned char *AbiMappedFileStream::getData() const
+{
+  return m_impl->m_data;
+}
+
+unsigned long AbiMappedFileStream::getSize() const
+{
+  return m_impl->m_size;
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,213 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <libabw/AbiPreparedDocument.h>
+
+#include <boost/optional.hpp>
+
+#include "ABWContentCollector.h"
+#include "ABWParseControl.h"
+#include "ABWParser.h"
+#include "ABWXMLHelper.h"
+#include "ABWZlibStream.h"
+#include "libabw_internal.h"
+
+namespace libabw
+{
+
+namespace
+{
+
+// small function needed to call the xml BAD_CAST on a char const *
+xmlChar *call_BAD_CAST_OnConst(char const *str)
+{
+  return BAD_CAST(const_cast<char *>(str));
+}
+
+bool isAbiWordDocument(librevenge::RVNGInputStream *const input)
+{
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  auto reader = xmlReaderForStream(input);
+  if (!reader)
+    return false;
+  int ret = xmlTextReaderRead(reader.get());
+  while (ret == 1 && XML_READER_TYPE_ELEMENT != xmlTextReaderNodeType(reader.get()))
+    ret = xmlTextReaderRead(reader.get());
+  if (ret != 1)
+    return false;
+  const xmlChar *name = xmlTextReaderConstName(reader.get());
+  if (!name)
+    return false;
+  if (!xmlStrEqual(name, call_BAD_CAST_OnConst("abiword")))
+  {
+    if (!xmlStrEqual(name, call_BAD_CAST_OnConst("awml")))
+      return false;
+  }
+
+  // Checking the namespace of AbiWord documents.
+  const xmlChar *nsname = xmlTextReaderConstNamespaceUri(reader.get());
+  if (!nsname)
+#if 1
+    return true; // Have seen some abiword files without NS declaration
+#else
+    return false;
+#endif
+  if (!xmlStrEqual(nsname, call_BAD_CAST_OnConst("http://www.abisource.com/awml.dtd")))
+    return false;
+
+  return true;
+}
+
+}
+
+struct AbiPreparedDocument::Impl
+{
+  Impl();
+
+  void open(librevenge::RVNGInputStream *input, const AbiParseOptions &options);
+
+  //! the control of the decompression and of all the reading, restarted by each parse()
+  std::unique_ptr<ABWParseControl> m_control;
+  std::unique_ptr<ABWZlibStream> m_stream;
+  //! the reason why m_stream could not be created
+  ABWResult m_openResult;
+  boost::optional<bool> m_isSupported;
+  std::unique_ptr<librevenge::RVNGPropertyList> m_metadata;
+  //! the document is inflated once, so only one parse counts the inflated size
+  bool m_isInflationCounted;
+
+private:
+  Impl(const Impl &);
+  Impl &operator=(const Impl &);
+};
+
+AbiPreparedDocument::Impl::Impl()
+  : m_control()
+  , m_stream()
+  , m_openResult(ABW_OK)
+  , m_isSupported()
+  , m_metadata()
+  , m_isInflationCounted(false)
+{
+}
+
+void AbiPreparedDocument::Impl::open(librevenge::RVNGInputStream *const input, const AbiParseOptions &options) try
+{
+  if (!input)
+  {
+    m_openResult = ABW_PARSE_ERROR;
+    return;
+  }
+  // the control checks the deadline as it is created
+  m_control.reset(new ABWParseControl(options));
+  input->seek(0, librevenge::RVNG_SEEK_SET);
+  ABWPhaseTimer timer(options.m_statistics, AbiParseStatistics::PHASE_DECOMPRESSION);
+  m_stream.reset(new ABWZlibStream(input, m_control.get(), options.m_pipelined));
+}
+catch (const ABWCancelledException &)
+{
+  m_openResult = ABW_CANCELLED;
+}
+catch (const ABWLimitExceededException &)
+{
+  m_openResult = ABW_LIMIT_EXCEEDED;
+}
+catch (...)
+{
+  m_openResult = ABW_PARSE_ERROR;
+}
+
+AbiPreparedDocument::AbiPreparedDocument(librevenge::RVNGInputStream *const input, const AbiParseOptions &options)
+  : m_impl(new Impl())
+{
+  m_impl->open(input, options);
+}
+
+AbiPreparedDocument::~AbiPreparedDocument()
+{
+}
+
+bool AbiPreparedDocument::isSupported()
+{
+  if (!m_impl->m_isSupported)
+  {
+    try
+    {
+      m_impl->m_isSupported = m_impl->m_stream && isAbiWordDocument(m_impl->m_stream.get());
+    }
+    catch (...)
+    {
+      m_impl->m_isSupported = false;
+    }
+  }
+  return get(m_impl->m_isSupported);
+}
+
+const librevenge::RVNGPropertyList &AbiPreparedDocument::getMetadata()
+{
+  if (!m_impl->m_metadata)
+  {
+    m_impl->m_metadata.reset(new librevenge::RVNGPropertyList());
+    if (isSupported())
+    {
+      ABWPropertyMap metadata;
+      try
+      {
+        ABWParser parser(m_impl->m_stream.get(), nullptr);
+        parser.parseMetadata(metadata);
+      }
+      catch (...)
+      {
+      }
+      ABWContentCollector::convertMetadata(metadata, *m_impl->m_metadata);
+    }
+  }
+  return *m_impl->m_metadata;
+}
+
+bool AbiPreparedDocument::parse(librevenge::RVNGTextInterface *const documentInterface)
+{
+  return parse(documentInterface, AbiParseOptions()) == ABW_OK;
+}
+
+ABWResult AbiPreparedDocument::parse(librevenge::RVNGTextInterface *const documentInterface, const AbiParseOptions &options) try
+{
+  if (!m_impl->m_stream)
+    return m_impl->m_openResult;
+
+  // the stream reports to the same control
+  m_impl->m_control->restart(options);
+  AbiParseStatistics *const statistics = options.m_statistics;
+  ABWParser parser(m_impl->m_stream.get(), documentInterface, statistics, m_impl->m_control.get(), options.m_xmlFrontend,
+                   options.m_contentThreads, options.m_dataThreads);
+  const bool isParsed = parser.parse();
+  // large documents are only inflated while they are parsed
+  if (statistics && !m_impl->m_isInflationCounted)
+  {
+    statistics->m_inflatedBytes += m_impl->m_stream->getSize();
+    m_impl->m_isInflationCounted = true;
+  }
+  return isParsed ? ABW_OK : ABW_PARSE_ERROR;
+}
+catch (const ABWCancelledException &)
+{
+  return ABW_CANCELLED;
+}
+catch (const ABWLimitExceededException &)
+{
+  return ABW_LIMIT_EXCEEDED;
+}
+catch (...)
+{
+  return ABW_PARSE_ERROR;
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -0,0 +1,390 @@
+/* -*- Mode: C++; tab-width: 2; indent-tabs-mode: nil; c-basic-offset: 2 -*- */
+/*
+ * This file is part of the libabw project.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <libabw/AbiReadAheadStream.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <string.h>
+
+#include "libabw_internal.h"
+
+namespace libabw
+{
+
+/* There are two blocks: the current one, which is read from, and the
+   next one, which the background thread fills. The next block is idle
+   (not pending), requested (pending, not ready) or filled (pending and
+   ready); the thread only touches it and the input while it is
+   requested. What reading the input throws on the thread is rethrown by
+   loadBlock(), on the thread the block is read from.
+  */
+struct AbiReadAheadStream::Impl
+{
+  Impl(librevenge::RVNGInputStream *input, unsigned long blockSize);
+  ~Impl();
+
+  void start();
+  void run();
+  //! read the block at offset from the input; returns its length
+  unsigned long readBlock(unsigned long offset, std::vector<unsigned char> &block);
+  //! make the block at offset current; returns false if it is empty
+  bool loadBlock(unsigned long offset);
+  //! to be called with m_mutex locked and the next block idle
+  void request(unsigned long offset);
+  //! the input, once the background thread does not use it
+  librevenge::RVNGInputStream *getIdleInput();
+
+  bool isInBlock(const unsigned long offset) const
+  {
+    return offset >= m_blockOffset && offset - m_blockOffset < m_blockLength;
+  }
+
+  librevenge::RVNGInputStream *const m_input;
+  const unsigned long m_blockSize;
+  //! whether the input is read ahead; if not, all calls are forwarded
+  bool m_isActive;
+  unsigned long m_size;
+  unsigned long m_offset;
+
+  std::vector<unsigned char> m_block;
+  unsigned long m_blockOffset;
+  unsigned long m_blockLength;
+
+  std::vector<unsigned char> m_next;
+  unsigned long m_nextOffset;
+  unsigned long m_nextLength;
+  std::exception_ptr m_nextException;
+  bool m_isNextPending;
+  bool m_isNextReady;
+
+  //! for reads that span several blocks
+  std::vector<unsigned char> m_buffer;
+
+  bool m_stop;
+  std::mutex m_mutex;
+  std::condition_variable m_condition;
+  std::thread m_thread;
+
+private:
+  Impl(const Impl &);
+  Impl &operator=(const Impl &);
+};
+
+AbiReadAheadStream::Impl::Impl(librevenge::RVNGInputStream *const input, const unsigned long blockSize)
+  : m_input(input)
+  , m_blockSize(std::max(blockSize, 1UL))
+  , m_isActive(false)
+  , m_size(0)
+  , m_offset(0)
+  , m_block()
+  , m_blockOffset(0)
+  , m_blockLength(0)
+  , m_next()
+  , m_nextOffset(0)
+  , m_nextLength(0)
+  , m_nextException()
+  , m_isNextPending(false)
+  , m_isNextReady(false)
+  , m_buffer()
+  , m_stop(false)
+  , m_mutex()
+  , m_condition()
+  , m_thread()
+{
+}
+
+AbiReadAheadStream::Impl::~Impl()
+{
+  if (m_thread.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_condition.notify_all();
+    m_thread.join();
+  }
+  if (m_isActive && m_input)
+    m_input->seek(long(m_offset), librevenge::RVNG_SEEK_SET);
+}
+
+void AbiReadAheadStream::Impl::start()
+{
+  if (!m_input)
+  {
+    // behave as an empty stream
+    m_isActive = true;
+    return;
+  }
+
+  const long start = m_input->tell();
+  if (start < 0 || m_input->seek(0, librevenge::RVNG_SEEK_END) != 0)
+  {
+    ABW_DEBUG_MSG(("AbiReadAheadStream: the input is not seekable, not reading ahead\n"));
+    if (start >= 0)
+      m_input->seek(start, librevenge::RVNG_SEEK_SET);
+    return;
+  }
+  const long end = m_input->tell();
+  if (end < start || m_input->seek(start, librevenge::RVNG_SEEK_SET) != 0)
+    return;
+
+  m_size = static_cast<unsigned long>(end);
+  m_offset = static_cast<unsigned long>(start);
+  m_block.resize(m_blockSize);
+  m_next.resize(m_blockSize);
+  try
+  {
+    m_thread = std::thread(&Impl::run, this);
+  }
+  catch (const std::system_error &)
+  {
+    ABW_DEBUG_MSG(("AbiReadAheadStream: cannot start the thread, not reading ahead\n"));
+    return;
+  }
+  m_isActive = true;
+
+  if (m_offset < m_size)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    request(m_offset);
+  }
+}
+
+void AbiReadAheadStream::Impl::run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_condition.wait(lock, [this] { return m_stop || (m_isNextPending && !m_isNextReady); });
+    if (m_stop)
+      return;
+    const unsigned long offset = m_nextOffset;
+    lock.unlock();
+    unsigned long length = 0;
+    std::exception_ptr exception;
+    try
+    {
+      length = readBlock(offset, m_next);
+    }
+    catch (...)
+    {
+      exception = std::current_exception();
+    }
+    lock.lock();
+    m_nextLength = length;
+    m_nextException = exception;
+    m_isNextReady = true;
+    m_condition.notify_all();
+  }
+}
+
+unsigned long AbiReadAheadStream::Impl::readBlock(const unsigned long offset, std::vector<unsigned char> &block)
+{
+  if (m_input->tell() != long(offset) && m_input->seek(long(offset), librevenge::RVNG_SEEK_SET) != 0)
+    return 0;
+  unsigned long length = 0;
+  while (length < m_blockSize)
+  {
+    unsigned long numBytesRead = 0;
+    const unsigned char *const data = m_input->read(m_blockSize - length, numBytesRead);
+    if (!data || numBytesRead == 0)
+      break;
+    memcpy(&block[length], data, numBytesRead);
+    length += numBytesRead;
+  }
+  return length;
+}
+
+bool AbiReadAheadStream::Impl::loadBlock(const unsigned long offset)
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  if (!m_isNextPending || m_nextOffset != offset)
+  {
+    // a seek: the block read ahead is not needed
+    m_condition.wait(lock, [this] { return !m_isNextPending || m_isNextReady; });
+    m_isNextPending = false;
+    request(offset);
+  }
+  m_condition.wait(lock, [this] { return m_isNextReady; });
+  if (m_nextException)
+  {
+    std::exception_ptr exception;
+    std::swap(exception, m_nextException);
+    m_isNextPending = false;
+    m_isNextReady = false;
+    std::rethrow_exception(exception);
+  }
+
+  m_block.swap(m_next);
+  m_blockOffset = m_nextOffset;
+  m_blockLength = m_nextLength;
+  m_isNextPending = false;
+  m_isNextReady = false;
+
+  const unsigned long nextOffset = m_blockOffset + m_blockLength;
+  if (m_blockLength == m_blockSize && nextOffset < m_size)
+    request(nextOffset);
+  return m_blockLength != 0;
+}
+
+void AbiReadAheadStream::Impl::request(const unsigned long offset)
+{
+  m_nextOffset = offset;
+  m_nextLength = 0;
+  m_nextException = nullptr;
+  m_isNextPending = true;
+  m_isNextReady = false;
+  m_condition.notify_all();
+}
+
+librevenge::RVNGInputStream *AbiReadAheadStream::Impl::getIdleInput()
+{
+  if (m_thread.joinable())
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_condition.wait(lock, [this] { return !m_isNextPending || m_isNextReady; });
+  }
+  return m_input;
+}
+
+AbiReadAheadStream::AbiReadAheadStream(librevenge::RVNGInputStream *const input, const unsigned long blockSize)
+  : librevenge::RVNGInputStream()
+  , m_impl(new Impl(input, blockSize))
+{
+  m_impl->start();
+}
+
+AbiReadAheadStream::~AbiReadAheadStream()
+{
+}
+
+bool AbiReadAheadStream::isStructured()
+{
+  librevenge::RVNGInputStream *const input = m_impl->getIdleInput();
+  return input && input->isStructured();
+}
+
+unsigned AbiReadAheadStream::subStreamCount()
+{
+  librevenge::RVNGInputStream *const input = m_impl->getIdleInput();
+  return input ? input->subStreamCount() : 0;
+}
+
+const char *AbiReadAheadStream::subStreamName(const unsigned id)
+{
+  librevenge::RVNGInputStream *const input = m_impl->getIdleInput();
+  return input ? input->subStreamName(id) : nullptr;
+}
+
+bool AbiReadAheadStream::existsSubStream(const char *const name)
+{
+  librevenge::RVNGInputStream *const input = m_impl->getIdleInput();
+  return input && input->existsSubStream(name);
+}
+
+librevenge::RVNGInputStream *AbiReadAheadStream::getSubStreamByName(const char *const name)
+{
+  librevenge::RVNGInputStream *const input = m_impl->getIdleInput();
+  return input ? input->getSubStreamByName(name) : nullptr;
+}
+
+librevenge::RVNGInputStream *AbiReadAheadStream::getSubStreamById(const unsigned id)
+{
+  librevenge::RVNGInputStream *const input = m_impl->getIdleInput();
+  return input ? input->getSubStreamById(id) : nullptr;
+}
+
+const unsigned char *AbiReadAheadStream::read(const unsigned long numBytes, unsigned long &numBytesRead)
+{
+  if (!m_impl->m_isActive)
+    return m_impl->m_input->read(numBytes, numBytesRead);
+
+  numBytesRead = 0;
+  if (numBytes == 0 || m_impl->m_offset >= m_impl->m_size)
+    return nullptr;
+  if (!m_impl->isInBlock(m_impl->m_offset) && !m_impl->loadBlock(m_impl->m_offset))
+    return nullptr;
+
+  const unsigned long available = m_impl->m_blockOffset + m_impl->m_blockLength - m_impl->m_offset;
+  if (numBytes <= available)
+  {
+    const unsigned char *const data = &m_impl->m_block[m_impl->m_offset - m_impl->m_blockOffset];
+    m_impl->m_offset += numBytes;
+    numBytesRead = numBytes;
+    return data;
+  }
+
+  // the read spans several blocks: collect them
+  const unsigned long size = std::min(numBytes, m_impl->m_size - m_impl->m_offset);
+  if (m_impl->m_buffer.size() < size)
+    m_impl->m_buffer.resize(size);
+  while (numBytesRead < size)
+  {
+    if (!m_impl->isInBlock(m_impl->m_offset) && !m_impl->loadBlock(m_impl->m_offset))
+      break;
+    const unsigned long count = std::min(size - numBytesRead, m_impl->m_blockOffset + m_impl->m_blockLength - m_impl->m_offset);
+    memcpy(&m_impl->m_buffer[numBytesRead], &m_impl->m_block[m_impl->m_offset - m_impl->m_blockOffset], count);
+    numBytesRead += count;
+    m_impl->m_offset += count;
+  }
+  return numBytesRead ? &m_impl->m_buffer[0] : nullptr;
+}
+
+int AbiReadAheadStream::seek(const long offset, const librevenge::RVNG_SEEK_TYPE seekType)
+{
+  if (!m_impl->m_isActive)
+    return m_impl->m_input->seek(offset, seekType);
+
+  // only the offset is changed; the block is read by the next read()
+  long pos = offset;
+  if (seekType == librevenge::RVNG_SEEK_CUR)
+    pos += long(m_impl->m_offset);
+  else if (seekType == librevenge::RVNG_SEEK_END)
+    pos += long(m_impl->m_size);
+
+  if (pos < 0)
+  {
+    m_impl->m_offset = 0;
+    return 1;
+  }
+  if (pos > long(m_impl->m_size))
+  {
+    m_impl->m_offset = m_impl->m_size;
+    return 1;
+  }
+
+  m_impl->m_offset = static_cast<unsigned long>(pos);
+  return 0;
+}
+
+long AbiReadAheadStream::tell()
+{
+  if (!m_impl->m_isActive)
+    return m_impl->m_input->tell();
+  return long(m_impl->m_offset);
+}
+
+bool AbiReadAheadStream::isEnd()
+{
+  if (!m_impl->m_isActive)
+    return m_impl->m_input->isEnd();
+  return m_impl->m_offset >= m_impl->m_size;
+}
+
+} // namespace libabw
+
+/* vim:set shiftwidth=2 softtabstop=2 expandtab: */
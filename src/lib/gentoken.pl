@@ -28,20 +28,31 @@
 $ARGV0 = shift @ARGV;
 $ARGV1 = shift @ARGV;
 $ARGV2 = shift @ARGV;
+# the prefix of the generated names; XML for the element names
+$PREFIX = shift @ARGV;
+$PREFIX = "XML" if not defined $PREFIX;
 
 open ( TOKENS, $ARGV0 ) || die "can't open token file: $!";
 my %tokens;
 
 while ( defined ($line = <TOKENS>) )
 {
-    if( !($line =~ /^#/) )
+    if( !($line =~ /^#/) && ($line =~ /\S/) )
     {
         chomp($line);
-        @token = split(/\s+/,$line);
+        # tokens containing spaces are separated from their name by a tab
+        if ( $line =~ /\t/ )
+        {
+            @token = split(/\t+/,$line);
+        }
+        else
+        {
+            @token = split(/\s+/,$line);
+        }
         if ( not defined ($token[1]) )
         {
-            $token[1] = "XML_".$token[0];
-            $token[1] =~ tr/\-\.\:/___/;
+            $token[1] = $PREFIX."_".$token[0];
+            $token[1] =~ tr/\-\.\: /____/;
             $token[1] =~ s/\+/PLUS/g;
             $token[1] =~ s/\-/MINUS/g;
         }
@@ -64,8 +75,8 @@ print ( GPERF "  const char *name;\n  int tokenId;\n" );
 print ( GPERF "};\n" );
 print ( GPERF "%%\n" );
 
-print ( HXX "#ifndef __ABWXMLTOKENS_HXX__\n" );
-print ( HXX "#define __ABWXMLTOKENS_HXX__\n" );
+print ( HXX "#ifndef __ABW".$PREFIX."TOKENS_HXX__\n" );
+print ( HXX "#define __ABW".$PREFIX."TOKENS_HXX__\n" );
 print ( HXX "\n" );
 
 $i = 0;
@@ -73,13 +84,20 @@ foreach( sort(keys(%tokens)) )
 {
     $i = $i + 1;
     print( HXX "const int $tokens{$_} = $i;\n" );
-    print( GPERF "$_,$tokens{$_}\n" );
+    if ( /[\s,"]/ )
+    {
+        print( GPERF "\"$_\",$tokens{$_}\n" );
+    }
+    else
+    {
+        print( GPERF "$_,$tokens{$_}\n" );
+    }
 }
 print ( GPERF "%%\n" );
 print ( HXX "\n" );
-print ( HXX "const int XML_TOKEN_COUNT = $i;\n" );
+print ( HXX "const int ".$PREFIX."_TOKEN_COUNT = $i;\n" );
 print ( HXX "\n" );
-print ( HXX "const int XML_TOKEN_INVALID = -1;\n" );
+print ( HXX "const int ".$PREFIX."_TOKEN_INVALID = -1;\n" );
 print ( HXX "\n" );
 print ( HXX "#endif\n" );
 close ( HXX );
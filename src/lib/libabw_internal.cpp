@@ -23,6 +23,34 @@ void debugPrint(const char *const format, ...)
   va_end(args);
 }
 
+ABWPhaseTimer::ABWPhaseTimer(AbiParseStatistics *const statistics, const AbiParseStatistics::Phase phase)
+  : m_statistics(statistics)
+  , m_phase(phase)
+  , m_wallStart()
+  , m_cpuStart(0)
+{
+  if (m_statistics)
+  {
+    m_wallStart = std::chrono::steady_clock::now();
+    m_cpuStart = std::clock();
+  }
+}
+
+ABWPhaseTimer::~ABWPhaseTimer()
+{
+  stop();
+}
+
+void ABWPhaseTimer::stop()
+{
+  if (!m_statistics)
+    return;
+  const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - m_wallStart;
+  m_statistics->m_wallTime[m_phase] += wall.count();
+  m_statistics->m_cpuTime[m_phase] += double(std::clock() - m_cpuStart) / CLOCKS_PER_SEC;
+  m_statistics = nullptr;
+}
+
 }
 
 /* vim:set shiftwidth=2 softtabstop=2 expandtab: */
@@ -22,9 +22,38 @@
 #define ABW_ATTRIBUTE_PRINTF(fmt, arg)
 #endif
 
+#include <chrono>
+#include <ctime>
+
+#include <libabw/AbiParseStatistics.h>
+
 namespace libabw
 {
 void debugPrint(const char *format, ...) ABW_ATTRIBUTE_PRINTF(1, 2);
+
+/** Adds the wall clock and processor time spent during its lifetime
+    to a phase of the parse statistics.
+
+    Does nothing (and does not query the clocks) if there are no statistics.
+  */
+class ABWPhaseTimer
+{
+public:
+  ABWPhaseTimer(AbiParseStatistics *statistics, AbiParseStatistics::Phase phase);
+  ~ABWPhaseTimer();
+
+  //! stop measuring now, instead of at destruction
+  void stop();
+
+private:
+  ABWPhaseTimer(const ABWPhaseTimer &);
+  ABWPhaseTimer &operator=(const ABWPhaseTimer &);
+
+  AbiParseStatistics *m_statistics;
+  AbiParseStatistics::Phase m_phase;
+  std::chrono::steady_clock::time_point m_wallStart;
+  std::clock_t m_cpuStart;
+};
 }
 
 #ifdef DEBUG